@@ -1,9 +1,25 @@
-mkdir exect
+mkdir -p exect
 cd exect
-rm *
-gcc -std=c99 -c ../source/lzma/*.c
-g++ -std=c++11 -c ../source/*.cpp -O2 -DNDEBUG
-g++ -o nmegtbdemo *.o
+rm -f *
+gcc -std=c99 -c ../src/lzma/*.c -O2
+gcc -std=c99 -c ../src/lz4/*.c -O2
+g++ -std=c++17 -c ../src/*.cpp -O2 -DNDEBUG
+g++ -o nmegtbdemo *.o -lpthread
+rm main.o
+g++ -std=c++17 -O2 -DNDEBUG -I../src -o probebench ../tools/probebench.cpp *.o -lpthread
+g++ -std=c++17 -O2 -DNDEBUG -I../src -o benchsuite ../tools/benchsuite.cpp *.o -lpthread
+g++ -std=c++17 -O2 -DNDEBUG -I../src -o fenscore ../tools/fenscore.cpp *.o -lpthread
+g++ -std=c++17 -O2 -DNDEBUG -I../src -o fencheck ../tools/fencheck.cpp *.o -lpthread
+g++ -std=c++17 -O2 -DNDEBUG -I../src -o tbdaemon ../tools/tbdaemon.cpp *.o -lpthread
+g++ -std=c++17 -O2 -DNDEBUG -I../src -o perft ../tools/perft.cpp *.o -lpthread
+g++ -std=c++17 -O2 -DNDEBUG -I../src -o zmtlz4 ../tools/zmtlz4.cpp *.o -lpthread
+g++ -std=c++17 -O2 -DNDEBUG -I../src -o gentb ../tools/gentb.cpp *.o -lpthread
+g++ -std=c++17 -O2 -DNDEBUG -I../src -o retrocheck ../tools/retrocheck.cpp *.o -lpthread
+g++ -std=c++17 -O2 -DNDEBUG -I../src -o derivetb ../tools/derivetb.cpp *.o -lpthread
+g++ -std=c++17 -O2 -DNDEBUG -I../src -o verifytb ../tools/verifytb.cpp *.o -lpthread
+g++ -std=c++17 -O2 -DNDEBUG -I../src -o keybench ../tools/keybench.cpp *.o -lpthread
+g++ -std=c++17 -O2 -DNDEBUG -I../src -o batchkeycheck ../tools/batchkeycheck.cpp *.o -lpthread
+g++ -std=c++17 -O2 -DNDEBUG -I../src -o catalog ../tools/catalog.cpp *.o -lpthread
 rm *.o
 cd ..
 ./exect/nmegtbdemo
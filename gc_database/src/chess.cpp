@@ -5,10 +5,24 @@
 #include <sstream>
 #include <iostream>
 #include <filesystem>
+#include <atomic>
+#include <future>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#include "chesspool.h"
 
 // for compression
 #include "lzma/7zTypes.h"
 #include "lzma/LzmaDec.h"
+#include "lz4/lz4.h"
 
 namespace chess {
 
@@ -45,6 +59,15 @@ std::string getVersion() {
     return buf;
 }
 
+chessMemMode parseMemMode(const std::string& str, chessMemMode defaultMode) {
+    if (str == "tiny") return chessMemMode::tiny;
+    if (str == "all") return chessMemMode::all;
+    if (str == "smart") return chessMemMode::smart;
+    if (str == "mapped") return chessMemMode::mapped;
+    if (str == "compressed") return chessMemMode::compressed;
+    return defaultMode;
+}
+
 #ifdef _WIN32
 static void findFiles(std::vector<std::string>& names, const std::string& dirname) {
     const std::string search_path = dirname + "/*.*";
@@ -85,6 +108,88 @@ std::vector<std::string> listdir(const std::string& dirname) {
 }
 
 
+#endif
+
+#ifdef _WIN32
+char* mapFile(const std::string& path, i64& length) {
+    length = 0;
+    auto fd = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (fd == INVALID_HANDLE_VALUE) {
+        return nullptr;
+    }
+
+    LARGE_INTEGER sz;
+    char* data = nullptr;
+    if (GetFileSizeEx(fd, &sz) && sz.QuadPart > 0) {
+        auto mmap = CreateFileMapping(fd, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mmap) {
+            data = (char*)MapViewOfFile(mmap, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mmap);
+            length = data ? sz.QuadPart : 0;
+        }
+    }
+    CloseHandle(fd);
+    return data;
+}
+
+void unmapFile(char* addr, i64) {
+    if (addr) {
+        UnmapViewOfFile(addr);
+    }
+}
+
+bool getFileStat(const std::string& path, i64& size, i64& modifiedTime) {
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &data)) {
+        return false;
+    }
+    size = ((i64)data.nFileSizeHigh << 32) | data.nFileSizeLow;
+    modifiedTime = ((i64)data.ftLastWriteTime.dwHighDateTime << 32) | data.ftLastWriteTime.dwLowDateTime;
+    return true;
+}
+
+#else
+
+char* mapFile(const std::string& path, i64& length) {
+    length = 0;
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+
+    struct stat st;
+    char* data = nullptr;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        auto p = ::mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (p != MAP_FAILED) {
+            data = (char*)p;
+            length = st.st_size;
+        }
+    }
+    ::close(fd);
+    return data;
+}
+
+void unmapFile(char* addr, i64 length) {
+    if (addr) {
+        ::munmap(addr, length);
+    }
+}
+
+bool getFileStat(const std::string& path, i64& size, i64& modifiedTime) {
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0) {
+        return false;
+    }
+    size = st.st_size;
+#ifdef __APPLE__
+    modifiedTime = (i64)st.st_mtimespec.tv_sec * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+    modifiedTime = (i64)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+    return true;
+}
+
 #endif
 
 static void* _allocForLzma(ISzAllocPtr, size_t size) {
@@ -99,42 +204,156 @@ static ISzAlloc _szAllocForLzma = { _allocForLzma, _freeForLzma };
 
 static const Byte lzmaPropData[5] = { 93, 0, 0, 0, 1 };
 
-    int decompress(char *dst, int uncompresslen, const char *src, int slen) {
-        SizeT srcLen = slen, dstLen = uncompresslen;
+/*
+ * LZMA decoder of a thread. Its probability model is allocated once and reused by all blocks,
+ * the destination buffer is used as the dictionary as LzmaDecode does, thus no copying
+ */
+class chessLzmaDecoder {
+public:
+    CLzmaDec state;
+    bool ready;
+
+    chessLzmaDecoder() {
+        LzmaDec_Construct(&state);
+        ready = LzmaDec_AllocateProbs(&state, lzmaPropData, LZMA_PROPS_SIZE, &_szAllocForLzma) == SZ_OK;
+    }
+
+    ~chessLzmaDecoder() {
+        LzmaDec_FreeProbs(&state, &_szAllocForLzma);
+    }
+};
+
+    static int decompressLzma(char *dst, int uncompresslen, const char *src, int slen) {
+        static thread_local chessLzmaDecoder decoder;
+
+        // 5: size of range coder initialising data
+        if (!decoder.ready || slen < 5) {
+            return -1;
+        }
+
+        auto& state = decoder.state;
+        SizeT srcLen = slen;
         ELzmaStatus lzmaStatus;
 
-        SRes res = LzmaDecode(
-                              (Byte *)dst, &dstLen,
-                              (const Byte *)src, &srcLen,
-                              lzmaPropData, LZMA_PROPS_SIZE,
-                              LZMA_FINISH_ANY,
-                              &lzmaStatus, &_szAllocForLzma
-                              );
+        state.dic = (Byte *)dst;
+        state.dicBufSize = uncompresslen;
+        LzmaDec_Init(&state);
+
+        SRes res = LzmaDec_DecodeToDic(&state, uncompresslen, (const Byte *)src, &srcLen, LZMA_FINISH_ANY, &lzmaStatus);
+        auto dstLen = state.dicPos;
+        state.dic = nullptr;
+
+        if (res == SZ_OK && lzmaStatus == LZMA_STATUS_NEEDS_MORE_INPUT) {
+            res = SZ_ERROR_INPUT_EOF;
+        }
         return res == SZ_OK ? (int)dstLen : -1;
     }
 
-    i64 decompressAllBlocks(int blocksize, int blocknum, u32* blocktable, char *dest, i64 uncompressedlen, const char *src, i64 slen) {
+    int decompress(char *dst, int uncompresslen, const char *src, int slen, chessCodec codec) {
+        chess_STATS_TIMER(startTime);
+        int len;
+        if (codec == chessCodec::lz4) {
+            auto dstLen = LZ4_decompress_safe(src, dst, slen, uncompresslen);
+            len = dstLen >= 0 ? dstLen : -1;
+        } else {
+            len = decompressLzma(dst, uncompresslen, src, slen);
+        }
+        chess_STATS_ADD_TIME(decompressNs, startTime);
+        chess_STATS_ADD(bytesDecompressed, MAX(len, 0));
+        return len;
+    }
+
+    int compressLz4(char *dst, int dstcapacity, const char *src, int slen) {
+        return LZ4_compress_limitedOutput(src, dst, slen, dstcapacity);
+    }
+
+    // Size of block i in the compressed data, -1 if the block table is broken. A stored block must fill its
+    // place in dest exactly, a compressed one may not be larger than readBlock takes
+    static int blockDataSize(const u32* blocktable, int i, int blocksize, int curBlockSize, i64 slen) {
+        i64 blockStart = i == 0 ? 0 : (blocktable[i - 1] & ~chess_UNCOMPRESS_BIT);
+        i64 blocksz = (i64)(blocktable[i] & ~chess_UNCOMPRESS_BIT) - blockStart;
+        bool stored = blocktable[i] & chess_UNCOMPRESS_BIT;
+
+        if (curBlockSize <= 0 || blocksz <= 0 || blockStart + blocksz > slen
+            || (stored ? blocksz != curBlockSize : blocksz > blocksize * 3 / 2)) {
+            return -1;
+        }
+        return (int)blocksz;
+    }
+
+    i64 decompressAllBlocks(int blocksize, int blocknum, u32* blocktable, char *dest, i64 uncompressedlen, const char *src, i64 slen, chessCodec codec) {
         auto *s = src;
         auto p = dest;
 
         for(int i = 0; i < blocknum; i++) {
-            int blocksz = (blocktable[i] & ~chess_UNCOMPRESS_BIT) - (i == 0 ? 0 : (blocktable[i - 1] & ~chess_UNCOMPRESS_BIT));
-            int uncompressed = blocktable[i] & chess_UNCOMPRESS_BIT;
+            auto left = uncompressedlen - (i64)(p - dest);
+            auto curBlockSize = (int)MIN(left, (i64)blocksize);
+            auto blocksz = blockDataSize(blocktable, i, blocksize, curBlockSize, slen);
+            if (blocksz < 0) {
+                return -1;
+            }
 
-            if (uncompressed) {
+            if (blocktable[i] & chess_UNCOMPRESS_BIT) {
                 memcpy(p, s, blocksz);
-                p += blocksz;
-            } else {
-                auto left = uncompressedlen - (i64)(p - dest);
-                auto curBlockSize = (int)MIN(left, (i64)blocksize);
-
-                auto originSz = decompress((char*)p, curBlockSize, s, blocksz);
-                p += originSz;
+            } else if (decompress((char*)p, curBlockSize, s, blocksz, codec) != curBlockSize) {
+                return -1;
             }
+            p += curBlockSize;
             s += blocksz;
         }
 
         return (i64)(p - dest);
     }
+
+    // All blocks but the last one are full, block i is decompressed to dest + i * blocksize
+    i64 decompressAllBlocksParallel(int blocksize, int blocknum, u32* blocktable, char *dest, i64 uncompressedlen, const char *src, i64 slen, chessCodec codec, chessThreadPool& pool) {
+        if (pool.getThreadCnt() <= 1 || blocknum < 2) {
+            return decompressAllBlocks(blocksize, blocknum, blocktable, dest, uncompressedlen, src, slen, codec);
+        }
+
+        std::atomic<i64> total(0);
+        std::atomic<bool> ok(true);
+
+        // More ranges than threads to balance blocks with different decompressing times
+        int rangeCnt = MIN(blocknum, pool.getThreadCnt() * 4);
+        std::vector<std::future<void>> futures;
+
+        for(int k = 0; k < rangeCnt; k++) {
+            int fromBlock = (int)((i64)blocknum * k / rangeCnt), toBlock = (int)((i64)blocknum * (k + 1) / rangeCnt);
+
+            futures.push_back(pool.submit([=, &total, &ok]() {
+                i64 sz = 0;
+                for(int i = fromBlock; i < toBlock && ok; i++) {
+                    auto blockStart = i == 0 ? 0 : (blocktable[i - 1] & ~chess_UNCOMPRESS_BIT);
+                    auto p = dest + (i64)i * blocksize;
+                    auto curBlockSize = (int)MIN(uncompressedlen - (i64)i * blocksize, (i64)blocksize);
+                    auto blocksz = blockDataSize(blocktable, i, blocksize, curBlockSize, slen);
+                    if (blocksz < 0) {
+                        ok = false;
+                        break;
+                    }
+
+                    if (blocktable[i] & chess_UNCOMPRESS_BIT) {
+                        memcpy(p, src + blockStart, blocksz);
+                        sz += blocksz;
+                    } else {
+                        auto originSz = decompress(p, curBlockSize, src + blockStart, blocksz, codec);
+                        if (originSz != curBlockSize) {
+                            ok = false;
+                            break;
+                        }
+                        sz += originSz;
+                    }
+                }
+                total += sz;
+            }));
+        }
+
+        for(auto && future : futures) {
+            future.wait();
+        }
+
+        return ok ? (i64)total : -1;
+    }
 }
 
@@ -90,6 +90,7 @@ namespace chess {
 #define chess_SIZE_COMPRESS_BLOCK        (4 * 1024)
 #define chess_PROP_COMPRESSED            (1 << 2)
 #define chess_PROP_SPECIAL_SCORE_RANGE   (1 << 3)
+#define chess_PROP_LZ4                   (1 << 4)   // with chess_PROP_COMPRESSED: blocks are compressed by LZ4, not LZMA
 
 #define chess_HEADER_SIZE                128
 
@@ -101,6 +102,23 @@ namespace chess {
 
 #define chess_SMART_MODE_THRESHOLD       10L * 1024 * 1024L
 
+// memMode smart of chessDb: memory for all files, they are loaded as all, compressed or tiny to fit into it
+#define chess_SMART_MEMORY_BUDGET        (512L * 1024 * 1024L)
+
+#define chess_BLOCK_CACHE_SIZE           (16L * 1024 * 1024L)
+#define chess_BLOCK_CACHE_SHARDS         16
+
+// Entries of the score cache of each thread probing a chessDb, 0: disabled
+#define chess_SCORE_CACHE_SIZE           0
+
+// memMode all: tables having at least that number of pieces are decompressed by many threads
+#define chess_PARALLEL_DECOMPRESS_PIECES 5
+
+// Counters of chessDb::stats(), build with -Dchess_STATS=0 to remove them from all code
+#ifndef chess_STATS
+#define chess_STATS                      1
+#endif
+
     const int chess_UNCOMPRESS_BIT       = 1 << 31;
 
     enum class Side {
@@ -164,7 +182,14 @@ namespace chess {
     enum chessMemMode {
         tiny,          // load minimum to memory
         all,            // load all data into memory, no access hard disk after loading
-        smart           // depend on data size, load as small or all mode
+        smart,          // depend on data size, load as small or all mode
+        mapped,         // map files into memory, read data and block tables directly from the mapping
+        compressed      // load compressed data and block tables into memory, decompress blocks on request
+    };
+
+    // Codec of compressed blocks, LZ4 decodes several times faster but files are bigger
+    enum class chessCodec {
+        lzma, lz4
     };
 
     enum chessLoadMode {
@@ -181,10 +206,26 @@ namespace chess {
     std::string posToCoordinateString(int pos);
     std::string getFileName(const std::string& path);
     std::string getVersion();
+    // Name of a memory mode as tools take it, defaultMode for unknown names
+    chessMemMode parseMemMode(const std::string& str, chessMemMode defaultMode = chessMemMode::smart);
     std::vector<std::string> listdir2(std::string dirname);
 
-    int decompress(char *dst, int uncompresslen, const char *src, int slen);
-    i64 decompressAllBlocks(int blocksize, int blocknum, u32* blocktable, char *dest, i64 uncompressedlen, const char *src, i64 slen);
+    char* mapFile(const std::string& path, i64& length);
+    void unmapFile(char* addr, i64 length);
+
+    // Size and last modified time (nanoseconds on POSIX, 100 ns units on Windows) of a file or a folder
+    bool getFileStat(const std::string& path, i64& size, i64& modifiedTime);
+
+    int decompress(char *dst, int uncompresslen, const char *src, int slen, chessCodec codec = chessCodec::lzma);
+    // Returns the decompressed size, -1 if a block is corrupt
+    i64 decompressAllBlocks(int blocksize, int blocknum, u32* blocktable, char *dest, i64 uncompressedlen, const char *src, i64 slen, chessCodec codec = chessCodec::lzma);
+    // Same as above, blocks are split into ranges and decompressed by tasks on the pool, the caller
+    // waits for them thus it must not be a task of the same pool. Returns -1 if a block is corrupt
+    class chessThreadPool;
+    i64 decompressAllBlocksParallel(int blocksize, int blocknum, u32* blocktable, char *dest, i64 uncompressedlen, const char *src, i64 slen, chessCodec codec, chessThreadPool& pool);
+
+    // LZ4 only (there is no LZMA encoder here), returns the compressed size or 0 if dst is too small
+    int compressLz4(char *dst, int dstcapacity, const char *src, int slen);
 
     // set it to true if you want to print out more messages
     extern bool chessVerbose;
@@ -196,15 +237,21 @@ namespace chess {
     class chessDb;
     class chessBoardCore;
     class chessMailBoard;
+    class chessBitBoard;
     class chessKeyRec;
     class chessKey;
+    class chessBlockCache;
+    class chessCatalog;
 
 } // namespace chess
 
+#include "chessstats.h"
 #include "chessBoard.h"
+#include "chesscache.h"
 #include "chessFile.h"
 #include "chessDb.h"
 #include "chessKey.h"
+#include "chesscatalog.h"
 
 
 #endif
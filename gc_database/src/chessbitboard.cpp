@@ -0,0 +1,497 @@
+#include "chess.h"
+#include "chessbitboard.h"
+
+using namespace chess;
+
+namespace chess {
+    const chessBitAttacks bitAttacks;
+}
+
+#ifdef chess_USE_PEXT
+
+static u16 sliderAttackTable[107648];
+
+#else
+
+/*
+ * Fixed shift magics found by Volker Annuss, the same ones used by syzygy magic.c.
+ * Their squares are numbered from A1 but masks and attacks depend on the grid only,
+ * thus the numbers work for our squares (from A8) as they are
+ */
+class MagicInit {
+public:
+    u64 magic;
+    int index;
+};
+
+static const MagicInit bishopMagicInit[64] = {
+    { 0x0000404040404040ULL,  33104 }, { 0x0000a060401007fcULL,   4094 },
+    { 0x0000401020200000ULL,  24764 }, { 0x0000806004000000ULL,  13882 },
+    { 0x0000440200000000ULL,  23090 }, { 0x0000080100800000ULL,  32640 },
+    { 0x0000104104004000ULL,  11558 }, { 0x0000020020820080ULL,  32912 },
+    { 0x0000040100202004ULL,  13674 }, { 0x0000020080200802ULL,   6109 },
+    { 0x0000010040080200ULL,  26494 }, { 0x0000008060040000ULL,  17919 },
+    { 0x0000004402000000ULL,  25757 }, { 0x00000021c100b200ULL,  17338 },
+    { 0x0000000400410080ULL,  16983 }, { 0x000003f7f05fffc0ULL,  16659 },
+    { 0x0004228040808010ULL,  13610 }, { 0x0000200040404040ULL,   2224 },
+    { 0x0000400080808080ULL,  60405 }, { 0x0000200200801000ULL,   7983 },
+    { 0x0000240080840000ULL,     17 }, { 0x000018000c03fff8ULL,  34321 },
+    { 0x00000a5840208020ULL,  33216 }, { 0x0000058408404010ULL,  17127 },
+    { 0x0002022000408020ULL,   6397 }, { 0x0000402000408080ULL,  22169 },
+    { 0x0000804000810100ULL,  42727 }, { 0x000100403c0403ffULL,    155 },
+    { 0x00078402a8802000ULL,   8601 }, { 0x0000101000804400ULL,  21101 },
+    { 0x0000080800104100ULL,  29885 }, { 0x0000400480101008ULL,  29340 },
+    { 0x0001010102004040ULL,  19785 }, { 0x0000808090402020ULL,  12258 },
+    { 0x0007fefe08810010ULL,  50451 }, { 0x0003ff0f833fc080ULL,   1712 },
+    { 0x007fe08019003042ULL,  78475 }, { 0x0000202040008040ULL,   7855 },
+    { 0x0001004008381008ULL,  13642 }, { 0x0000802003700808ULL,   8156 },
+    { 0x0000208200400080ULL,   4348 }, { 0x0000104100200040ULL,  28794 },
+    { 0x0003ffdf7f833fc0ULL,  22578 }, { 0x0000008840450020ULL,  50315 },
+    { 0x0000020040100100ULL,  85452 }, { 0x007fffdd80140028ULL,  32816 },
+    { 0x0000202020200040ULL,  13930 }, { 0x0001004010039004ULL,  17967 },
+    { 0x0000040041008000ULL,  33200 }, { 0x0003ffefe0c02200ULL,  32456 },
+    { 0x0000001010806000ULL,   7762 }, { 0x0000000008403000ULL,   7794 },
+    { 0x0000000100202000ULL,  22761 }, { 0x0000040100200800ULL,  14918 },
+    { 0x0000404040404000ULL,  11620 }, { 0x00006020601803f4ULL,  15925 },
+    { 0x0003ffdfdfc28048ULL,  32528 }, { 0x0000000820820020ULL,  12196 },
+    { 0x0000000010108060ULL,  32720 }, { 0x0000000000084030ULL,  26781 },
+    { 0x0000000001002020ULL,  19817 }, { 0x0000000040408020ULL,  24732 },
+    { 0x0000004040404040ULL,  25468 }, { 0x0000404040404040ULL,  10186 },
+};
+
+static const MagicInit rookMagicInit[64] = {
+    { 0x00280077ffebfffeULL,  41305 }, { 0x2004010201097fffULL,  14326 },
+    { 0x0010020010053fffULL,  24477 }, { 0x0030002ff71ffffaULL,   8223 },
+    { 0x7fd00441ffffd003ULL,  49795 }, { 0x004001d9e03ffff7ULL,  60546 },
+    { 0x004000888847ffffULL,  28543 }, { 0x006800fbff75fffdULL,  79282 },
+    { 0x000028010113ffffULL,   6457 }, { 0x0020040201fcffffULL,   4125 },
+    { 0x007fe80042ffffe8ULL,  81021 }, { 0x00001800217fffe8ULL,  42341 },
+    { 0x00001800073fffe8ULL,  14139 }, { 0x007fe8009effffe8ULL,  19465 },
+    { 0x00001800602fffe8ULL,   9514 }, { 0x000030002fffffa0ULL,  71090 },
+    { 0x00300018010bffffULL,  75419 }, { 0x0003000c0085fffbULL,  33476 },
+    { 0x0004000802010008ULL,  27117 }, { 0x0002002004002002ULL,  85964 },
+    { 0x0002002020010002ULL,  54915 }, { 0x0001002020008001ULL,  36544 },
+    { 0x0000004040008001ULL,  71854 }, { 0x0000802000200040ULL,  37996 },
+    { 0x0040200010080010ULL,  30398 }, { 0x0000080010040010ULL,  55939 },
+    { 0x0004010008020008ULL,  53891 }, { 0x0000040020200200ULL,  56963 },
+    { 0x0000010020020020ULL,  77451 }, { 0x0000010020200080ULL,  12319 },
+    { 0x0000008020200040ULL,  88500 }, { 0x0000200020004081ULL,  51405 },
+    { 0x00fffd1800300030ULL,  72878 }, { 0x007fff7fbfd40020ULL,    676 },
+    { 0x003fffbd00180018ULL,  83122 }, { 0x001fffde80180018ULL,  22206 },
+    { 0x000fffe0bfe80018ULL,  75186 }, { 0x0001000080202001ULL,    681 },
+    { 0x0003fffbff980180ULL,  36453 }, { 0x0001fffdff9000e0ULL,  20369 },
+    { 0x00fffeebfeffd800ULL,   1981 }, { 0x007ffff7ffc01400ULL,  13343 },
+    { 0x0000408104200204ULL,  10650 }, { 0x001ffff01fc03000ULL,  57987 },
+    { 0x000fffe7f8bfe800ULL,  26302 }, { 0x0000008001002020ULL,  58357 },
+    { 0x0003fff85fffa804ULL,  40546 }, { 0x0001fffd75ffa802ULL,      0 },
+    { 0x00ffffec00280028ULL,  14967 }, { 0x007fff75ff7fbfd8ULL,  80361 },
+    { 0x003fff863fbf7fd8ULL,  40905 }, { 0x001fffbfdfd7ffd8ULL,  58347 },
+    { 0x000ffff810280028ULL,  20381 }, { 0x0007ffd7f7feffd8ULL,  81868 },
+    { 0x0003fffc0c480048ULL,  59381 }, { 0x0001ffffafd7ffd8ULL,  84404 },
+    { 0x00ffffe4ffdfa3baULL,  45811 }, { 0x007fffef7ff3d3daULL,  62898 },
+    { 0x003fffbfdfeff7faULL,  45796 }, { 0x001fffeff7fbfc22ULL,  66994 },
+    { 0x0000020408001001ULL,  67204 }, { 0x0007fffeffff77fdULL,  32448 },
+    { 0x0003ffffbf7dfeecULL,  62946 }, { 0x0001ffff9dffa333ULL,  17005 },
+};
+
+static u64 sliderAttackTable[89524];
+
+#endif
+
+static const int bishopDir[4][2] = {
+    { -1, -1 }, { -1, 1 }, { 1, -1 }, { 1, 1 }
+};
+
+static const int rookDir[4][2] = {
+    { -1, 0 }, { 0, -1 }, { 0, 1 }, { 1, 0 }
+};
+
+// Attacks by walking along directions, stop at the first occupied square
+static u64 slideAttacks(int pos, u64 occ, const int dir[4][2]) {
+    u64 bb = 0;
+    for(int i = 0; i < 4; i++) {
+        for(int r = ROW(pos) + dir[i][0], f = COL(pos) + dir[i][1]; r >= 0 && r < 8 && f >= 0 && f < 8; r += dir[i][0], f += dir[i][1]) {
+            bb |= bitOf(r * 8 + f);
+            if (occ & bitOf(r * 8 + f)) {
+                break;
+            }
+        }
+    }
+    return bb;
+}
+
+// Squares which may block, the last squares on the edges are not needed
+static u64 slideMask(int pos, const int dir[4][2]) {
+    u64 bb = 0;
+    for(int i = 0; i < 4; i++) {
+        for(int r = ROW(pos) + dir[i][0], f = COL(pos) + dir[i][1];
+            r + dir[i][0] >= 0 && r + dir[i][0] < 8 && f + dir[i][1] >= 0 && f + dir[i][1] < 8;
+            r += dir[i][0], f += dir[i][1]) {
+            bb |= bitOf(r * 8 + f);
+        }
+    }
+    return bb;
+}
+
+chessBitAttacks::chessBitAttacks() {
+    static const int kingDir[8][2] = { { -1, -1 }, { -1, 0 }, { -1, 1 }, { 0, -1 }, { 0, 1 }, { 1, -1 }, { 1, 0 }, { 1, 1 } };
+    static const int knightDir[8][2] = { { -2, -1 }, { -2, 1 }, { -1, -2 }, { -1, 2 }, { 1, -2 }, { 1, 2 }, { 2, -1 }, { 2, 1 } };
+
+    for(int pos = 0; pos < 64; pos++) {
+        int r = ROW(pos), f = COL(pos);
+        king[pos] = knight[pos] = 0;
+        for(int i = 0; i < 8; i++) {
+            int r1 = r + kingDir[i][0], f1 = f + kingDir[i][1];
+            if (r1 >= 0 && r1 < 8 && f1 >= 0 && f1 < 8) {
+                king[pos] |= bitOf(r1 * 8 + f1);
+            }
+            r1 = r + knightDir[i][0], f1 = f + knightDir[i][1];
+            if (r1 >= 0 && r1 < 8 && f1 >= 0 && f1 < 8) {
+                knight[pos] |= bitOf(r1 * 8 + f1);
+            }
+        }
+
+        // White pawns go up (to row 0)
+        pawn[W][pos] = pawn[B][pos] = 0;
+        if (r > 0) {
+            if (f > 0) pawn[W][pos] |= bitOf(pos - 9);
+            if (f < 7) pawn[W][pos] |= bitOf(pos - 7);
+        }
+        if (r < 7) {
+            if (f > 0) pawn[B][pos] |= bitOf(pos + 7);
+            if (f < 7) pawn[B][pos] |= bitOf(pos + 9);
+        }
+    }
+
+    auto idx = initSliders(bishopInfo, bishopDir, false, 0);
+    initSliders(rookInfo, rookDir, true, idx);
+}
+
+// Returns the next free index of the table (used with PEXT only)
+int chessBitAttacks::initSliders(SliderInfo* info, const int dir[4][2], bool rook, int idx) {
+    for(int pos = 0; pos < 64; pos++) {
+        auto mask = slideMask(pos, dir);
+        info[pos].mask = mask;
+
+#ifdef chess_USE_PEXT
+        info[pos].data = sliderAttackTable + idx;
+        info[pos].attackMask = slideAttacks(pos, 0, dir);
+        idx += 1 << __builtin_popcountll(mask);
+        assert(idx <= (int)(sizeof(sliderAttackTable) / sizeof(sliderAttackTable[0])));
+#else
+        auto& init = rook ? rookMagicInit[pos] : bishopMagicInit[pos];
+        info[pos].magic = init.magic;
+        info[pos].data = sliderAttackTable + init.index;
+        int shift = rook ? 64 - 12 : 64 - 9;
+#endif
+
+        // All subsets of the mask
+        u64 occ = 0;
+        do {
+            auto att = slideAttacks(pos, occ, dir);
+#ifdef chess_USE_PEXT
+            info[pos].data[_pext_u64(occ, mask)] = (u16)_pext_u64(att, info[pos].attackMask);
+#else
+            info[pos].data[(occ * info[pos].magic) >> shift] = att;
+#endif
+            occ = (occ - mask) & mask;
+        } while (occ);
+    }
+    return idx;
+}
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+bool chessBitBoard::setup(const std::vector<Piece> pieceVec, Side _side, Squares _enpassant) {
+    pieceList_reset((Piece *)pieceList);
+    reset();
+    materialKey = 0;
+    hashKey = 0;
+
+    side = _side;
+    for (auto && p : pieceVec) {
+        if (p.isEmpty()) {
+            continue;
+        }
+
+        if (p.idx < 0 || p.idx >= 64 || !isEmpty(p.idx)) {
+            return false;
+        }
+        setPiece(p.idx, p);
+        pieceList_set((Piece *)pieceList, p.idx, p.type, p.side);
+        materialKey += materialKeyOf(p.type, p.side);
+        hashKey ^= zobrist.piece(p.type, p.side, p.idx);
+    }
+
+    enpassant = static_cast<int>(_enpassant);
+    checkEnpassant();
+    return true;
+}
+
+void chessBitBoard::gen(MoveList& moves, Side side, bool captureOnly) const {
+    assert(isValid());
+
+    auto sd = static_cast<int>(side), xsd = 1 - sd;
+    auto occ = occupied();
+    auto targets = captureOnly ? bbSides[xsd] : ~bbSides[sd];
+
+    for (u64 bb = bbSides[sd]; bb; ) {
+        int pos = popFirstBit(bb);
+        auto type = pieces[pos].type;
+
+        switch (type) {
+            case PieceType::king:
+            {
+                gen_addMoves(moves, type, side, pos, bitAttacks.king[pos] & targets);
+
+                if (captureOnly) {
+                    break;
+                }
+                if ((pos ==  4 && castleRights[B]) ||
+                    (pos == 60 && castleRights[W])) {
+                    if (pos == 4) {
+                        if ((castleRights[B] & CASTLERIGHT_LONG) &&
+                            !(occ & (bitOf(1) | bitOf(2) | bitOf(3))) &&
+                            !beAttacked(2, Side::white) && !beAttacked(3, Side::white)) {
+                            assert(isPiece(0, PieceType::rook, Side::black));
+                            moves.add(type, side, 4, 2);
+                        }
+                        if ((castleRights[B] & CASTLERIGHT_SHORT) &&
+                            !(occ & (bitOf(5) | bitOf(6))) &&
+                            !beAttacked(5, Side::white) && !beAttacked(6, Side::white)) {
+                            assert(isPiece(7, PieceType::rook, Side::black));
+                            moves.add(type, side, 4, 6);
+                        }
+                    } else {
+                        if ((castleRights[W] & CASTLERIGHT_LONG) &&
+                            !(occ & (bitOf(57) | bitOf(58) | bitOf(59))) &&
+                            !beAttacked(58, Side::black) && !beAttacked(59, Side::black)) {
+                            assert(isPiece(56, PieceType::rook, Side::white));
+                            moves.add(type, side, 60, 58);
+                        }
+                        if ((castleRights[W] & CASTLERIGHT_SHORT) &&
+                            !(occ & (bitOf(61) | bitOf(62))) &&
+                            !beAttacked(61, Side::black) && !beAttacked(62, Side::black)) {
+                            assert(isPiece(63, PieceType::rook, Side::white));
+                            moves.add(type, side, 60, 62);
+                        }
+                    }
+                }
+                break;
+            }
+
+            case PieceType::queen:
+                gen_addMoves(moves, type, side, pos, bitAttacks.queen(pos, occ) & targets);
+                break;
+
+            case PieceType::rook:
+                gen_addMoves(moves, type, side, pos, bitAttacks.rook(pos, occ) & targets);
+                break;
+
+            case PieceType::bishop:
+                gen_addMoves(moves, type, side, pos, bitAttacks.bishop(pos, occ) & targets);
+                break;
+
+            case PieceType::knight:
+                gen_addMoves(moves, type, side, pos, bitAttacks.knight[pos] & targets);
+                break;
+
+            case PieceType::pawn:
+            {
+                // Enpassant captures are not added for captureOnly, the same as the mailbox board
+                auto caps = bbSides[xsd];
+                if (!captureOnly && enpassant > 0 && isEmpty(enpassant)) {
+                    caps |= bitOf(enpassant);
+                }
+                auto dests = bitAttacks.pawn[sd][pos] & caps;
+
+                if (!captureOnly) {
+                    int d = side == Side::black ? 8 : -8;
+                    if (!(occ & bitOf(pos + d))) {
+                        dests |= bitOf(pos + d);
+                        if ((side == Side::black ? pos < 16 : pos >= 48) && !(occ & bitOf(pos + 2 * d))) {
+                            dests |= bitOf(pos + 2 * d);
+                        }
+                    }
+                }
+
+                while (dests) {
+                    int dest = popFirstBit(dests);
+                    if (dest >= 8 && dest < 56) {
+                        moves.add(type, side, pos, dest);
+                    } else {
+                        moves.add(type, side, pos, dest, PieceType::queen);
+                        moves.add(type, side, pos, dest, PieceType::rook);
+                        moves.add(type, side, pos, dest, PieceType::bishop);
+                        moves.add(type, side, pos, dest, PieceType::knight);
+                    }
+                }
+                break;
+            }
+
+            default:
+                break;
+        }
+    }
+}
+
+// Pieces but pawns move back the same way they move forward, into empty squares only
+void chessBitBoard::genRetro(RetroMoveList& moveList, Side side, bool uncaptures, bool unpromotions) const {
+    auto sd = static_cast<int>(side);
+    auto occ = occupied();
+    auto lastRow = side == Side::white ? 0 : 7;
+    uncaptures = uncaptures && genRetro_canUncapture(side);
+
+    for (u64 bb = bbSides[sd]; bb; ) {
+        int pos = popFirstBit(bb);
+        auto type = pieces[pos].type;
+
+        u64 froms;
+        switch (type) {
+            case PieceType::king:
+                froms = bitAttacks.king[pos];
+                break;
+            case PieceType::queen:
+                froms = bitAttacks.queen(pos, occ);
+                break;
+            case PieceType::rook:
+                froms = bitAttacks.rook(pos, occ);
+                break;
+            case PieceType::bishop:
+                froms = bitAttacks.bishop(pos, occ);
+                break;
+            case PieceType::knight:
+                froms = bitAttacks.knight[pos];
+                break;
+            case PieceType::pawn:
+                genRetro_pawn(moveList, pos, side, uncaptures);
+                continue;
+            default:
+                continue;
+        }
+
+        if (unpromotions && type != PieceType::king && ROW(pos) == lastRow) {
+            genRetro_unpromotions(moveList, pos, type, side, uncaptures);
+        }
+
+        for (froms &= ~occ; froms; ) {
+            genRetro_addMove(moveList, Move(type, side, popFirstBit(froms), pos), true, uncaptures);
+        }
+    }
+}
+
+bool chessBitBoard::beAttacked(int pos, Side attackerSide) const
+{
+    auto sd = static_cast<int>(attackerSide);
+    auto p = bbPieces[sd];
+
+    if ((bitAttacks.knight[pos] & p[static_cast<int>(PieceType::knight)]) ||
+        (bitAttacks.king[pos] & p[static_cast<int>(PieceType::king)]) ||
+        (bitAttacks.pawn[1 - sd][pos] & p[static_cast<int>(PieceType::pawn)])) {
+        return true;
+    }
+
+    auto occ = occupied();
+    auto queens = p[static_cast<int>(PieceType::queen)];
+    return (bitAttacks.rook(pos, occ) & (queens | p[static_cast<int>(PieceType::rook)])) ||
+           (bitAttacks.bishop(pos, occ) & (queens | p[static_cast<int>(PieceType::bishop)]));
+}
+
+void chessBitBoard::make(const Move& move, Hist& hist) {
+    hist.enpassant = enpassant;
+    hist.status = _status;
+    hist.castleRights[0] = castleRights[0];
+    hist.castleRights[1] = castleRights[1];
+    hist.move = move;
+    hist.cap = pieces[move.dest];
+
+    auto p = pieces[move.from];
+    setPiece(move.dest, p);
+    setEmpty(move.from);
+
+    enpassant = -1;
+
+    if ((castleRights[0] + castleRights[1]) && hist.cap.type == PieceType::rook) {
+        clearCastleRights(move.dest, hist.cap.side);
+    }
+
+    switch (p.type) {
+        case PieceType::king: {
+            if (p.side == Side::white) {
+                castleRights[W] &= ~(CASTLERIGHT_LONG|CASTLERIGHT_SHORT);
+            } else {
+                castleRights[B] &= ~(CASTLERIGHT_LONG|CASTLERIGHT_SHORT);
+            }
+
+            if (abs(move.from - move.dest) == 2) { // castle
+                int rookPos = move.from + (move.from < move.dest ? 3 : -4);
+                int newRookPos = (move.from + move.dest) / 2;
+                setPiece(newRookPos, pieces[rookPos]);
+                setEmpty(rookPos);
+            }
+            break;
+        }
+
+        case PieceType::rook: {
+            if (castleRights[0] + castleRights[1]) {
+                clearCastleRights(move.from, p.side);
+            }
+            break;
+        }
+
+        case PieceType::pawn: {
+            int d = abs(move.from - move.dest);
+
+            if (d == 16) {
+                enpassant = (move.from + move.dest) / 2;
+            } else if (move.dest == hist.enpassant) {
+                int ep = move.dest + (p.side == Side::white ? +8 : -8);
+                hist.cap = pieces[ep];
+                setEmpty(ep);
+            } else {
+                if (move.promote != PieceType::empty) {
+                    p.type = move.promote;
+                    setPiece(move.dest, p);
+                }
+            }
+            break;
+        }
+        default:
+            break;
+    }
+
+    pieceList_make(hist);
+}
+
+void chessBitBoard::takeBack(const Hist& hist) {
+    auto p = pieces[hist.move.dest];
+    if (hist.move.promote != PieceType::empty) {
+        p.type = PieceType::pawn;
+    }
+    setPiece(hist.move.from, p);
+
+    int capPos = hist.move.dest;
+
+    if (p.type == PieceType::pawn && hist.enpassant == hist.move.dest) {
+        capPos = hist.move.dest + (p.side == Side::white ? +8 : -8);
+        setEmpty(hist.move.dest);
+    }
+    setPiece(capPos, hist.cap);
+
+    if (p.type == PieceType::king) {
+        if (abs(hist.move.from - hist.move.dest) == 2) {
+            int rookPos = hist.move.from + (hist.move.from < hist.move.dest ? 3 : -4);
+            int newRookPos = (hist.move.from + hist.move.dest) / 2;
+            setPiece(rookPos, pieces[newRookPos]);
+            setEmpty(newRookPos);
+        }
+    }
+
+    _status = hist.status;
+    castleRights[0] = hist.castleRights[0];
+    castleRights[1] = hist.castleRights[1];
+    enpassant = hist.enpassant;
+
+    pieceList_takeback(hist);
+}
@@ -0,0 +1,190 @@
+#ifndef chessBitBoard_h
+#define chessBitBoard_h
+
+#include "chess.h"
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#define chess_USE_PEXT
+#elif defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace chess {
+
+    // Bit i of a bitboard is square i (A8 = 0, H1 = 63)
+    static inline u64 bitOf(int pos) {
+        return 1ULL << pos;
+    }
+
+    static inline int firstBit(u64 bb) {
+        assert(bb);
+#if defined(_MSC_VER)
+        unsigned long idx;
+        _BitScanForward64(&idx, bb);
+        return (int)idx;
+#else
+        return __builtin_ctzll(bb);
+#endif
+    }
+
+    static inline int popFirstBit(u64& bb) {
+        int pos = firstBit(bb);
+        bb &= bb - 1;
+        return pos;
+    }
+
+    /*
+     * Attack tables, built once at startup. Sliding pieces use PEXT when compiled for BMI2,
+     * otherwise fixed shift magics
+     */
+    class chessBitAttacks {
+    public:
+        u64 king[64], knight[64];
+        u64 pawn[2][64];           // squares attacked by a pawn of the side
+
+        chessBitAttacks();
+
+        u64 bishop(int pos, u64 occ) const {
+            auto& info = bishopInfo[pos];
+#ifdef chess_USE_PEXT
+            return _pdep_u64(info.data[_pext_u64(occ, info.mask)], info.attackMask);
+#else
+            return info.data[((occ & info.mask) * info.magic) >> (64 - 9)];
+#endif
+        }
+
+        u64 rook(int pos, u64 occ) const {
+            auto& info = rookInfo[pos];
+#ifdef chess_USE_PEXT
+            return _pdep_u64(info.data[_pext_u64(occ, info.mask)], info.attackMask);
+#else
+            return info.data[((occ & info.mask) * info.magic) >> (64 - 12)];
+#endif
+        }
+
+        u64 queen(int pos, u64 occ) const {
+            return bishop(pos, occ) | rook(pos, occ);
+        }
+
+    private:
+        class SliderInfo {
+        public:
+            u64 mask;
+#ifdef chess_USE_PEXT
+            u64 attackMask;
+            u16* data;
+#else
+            u64 magic;
+            u64* data;
+#endif
+        };
+
+        SliderInfo bishopInfo[64], rookInfo[64];
+
+        int initSliders(SliderInfo* info, const int dir[4][2], bool rook, int idx);
+    };
+
+    extern const chessBitAttacks bitAttacks;
+
+    /*
+     * Board keeps both a mailbox (for getPiece) and bitboards (for generating moves and attacks)
+     */
+    class chessBitBoard final : public chessBoardBase<chessBitBoard> {
+    protected:
+        Piece pieces[64];
+        u64 bbPieces[2][6];
+        u64 bbSides[2];
+
+    public:
+        chessBitBoard() {
+            for (int i = 0; i < 64; i++) {
+                pieces[i].setEmpty();
+            }
+            memset(bbPieces, 0, sizeof(bbPieces));
+            bbSides[0] = bbSides[1] = 0;
+        }
+
+        void setPiece(int pos, Piece piece) {
+            assert(isPositionValid(pos));
+            clearBits(pos);
+            pieces[pos] = piece;
+            if (!piece.isEmpty()) {
+                auto sd = static_cast<int>(piece.side);
+                bbPieces[sd][static_cast<int>(piece.type)] |= bitOf(pos);
+                bbSides[sd] |= bitOf(pos);
+            }
+        }
+
+        Piece getPiece(int pos) const {
+            assert(isPositionValid(pos));
+            return pieces[pos];
+        }
+
+        bool isEmpty(int pos) const {
+            assert(isPositionValid(pos));
+            return pieces[pos].type == PieceType::empty;
+        }
+
+        bool isPiece(int pos, PieceType type, Side side) const {
+            assert(isPositionValid(pos));
+            auto p = pieces[pos];
+            return p.type==type && p.side==side;
+        }
+
+        void setEmpty(int pos) {
+            assert(isPositionValid(pos));
+            clearBits(pos);
+            pieces[pos].setEmpty();
+        }
+
+        bool setup(const std::vector<Piece> pieceVec, Side side, Squares enpassant = Squares::NoSquare);
+
+        u64 occupied() const {
+            return bbSides[0] | bbSides[1];
+        }
+
+        u64 getBitBoard(PieceType type, Side side) const {
+            return bbPieces[static_cast<int>(side)][static_cast<int>(type)];
+        }
+
+        void gen(MoveList& moveList, Side side, bool capOnly) const;
+        void genRetro(RetroMoveList& moveList, Side side, bool uncaptures = true, bool unpromotions = true) const;
+
+        virtual bool beAttacked(int pos, Side attackerSide) const;
+
+        void make(const Move& move, Hist& hist);
+        void takeBack(const Hist& hist);
+
+        int findKing(Side side) const {
+            auto bb = bbPieces[static_cast<int>(side)][static_cast<int>(PieceType::king)];
+            return bb ? firstBit(bb) : -1;
+        }
+
+    private:
+        void clearBits(int pos) {
+            auto p = pieces[pos];
+            if (!p.isEmpty()) {
+                auto sd = static_cast<int>(p.side);
+                bbPieces[sd][static_cast<int>(p.type)] &= ~bitOf(pos);
+                bbSides[sd] &= ~bitOf(pos);
+            }
+        }
+
+        void gen_addMoves(MoveList& moveList, PieceType type, Side side, int from, u64 dests) const {
+            while (dests) {
+                moveList.add(type, side, from, popFirstBit(dests));
+            }
+        }
+    };
+
+    // Board used by chessDb for its own boards, define chess_MAILBOX_BOARD to use the mailbox one
+#ifdef chess_MAILBOX_BOARD
+    typedef chessBoard chessProbeBoard;
+#else
+    typedef chessBitBoard chessProbeBoard;
+#endif
+
+} // namespace chess
+
+#endif /* chessBitBoard_h */
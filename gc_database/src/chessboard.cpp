@@ -15,7 +15,37 @@ namespace chess {
 using namespace chess;
 
 
+namespace chess {
+    const chessZobrist zobrist;
+}
+
+// splitmix64, keys are the same for all runs
+chessZobrist::chessZobrist() {
+    u64 seed = 0x6a09e667f3bcc909ULL;
+    auto next = [&]() {
+        auto z = (seed += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    };
+
+    for (auto && sidePieces : pieces) {
+        for (auto && typePieces : sidePieces) {
+            for (auto && key : typePieces) {
+                key = next();
+            }
+        }
+    }
+    sides[0] = next();
+    sides[1] = next();
+    for (auto && key : enpassants) {
+        key = next();
+    }
+}
+
 chessBoardCore::chessBoardCore() {
+    materialKey = 0;
+    hashKey = 0;
 }
 
 bool chessBoardCore::isValid() const {
@@ -82,6 +112,12 @@ bool chessBoardCore::isValid() const {
     return b;
 }
 
+bool chessBoardCore::isLegal() const {
+    // isValid asserts on missing kings
+    return side != Side::none && pieceList[W][0].type == PieceType::king && pieceList[B][0].type == PieceType::king
+           && isValid() && !isIncheck(getXSide(side));
+}
+
 void chessBoardCore::checkEnpassant() {
     if ((enpassant >= 16 && enpassant < 24) || (enpassant >= 40 && enpassant < 48))  {
         int d = 8, xsd = W, r = 3;
@@ -219,13 +255,19 @@ std::string chessBoardCore::toString() const {
 }
 
 void chessBoardCore::setFen(const std::string& fen) {
-    pieceList_reset((Piece *)pieceList);
-    reset();
-
-    std::string thefen = fen;
     if (fen.empty()) {
-        thefen = startingFen;
+        setFen(startingFen, strlen(startingFen));
+    } else {
+        setFen(fen.c_str(), fen.length());
     }
+}
+
+// It reads the string in place, no copy
+void chessBoardCore::setFen(const char* fen, size_t len) {
+    pieceList_reset((Piece *)pieceList);
+    reset();
+    materialKey = 0;
+    hashKey = 0;
 
     bool last = false;
     side = Side::none;
@@ -233,8 +275,9 @@ void chessBoardCore::setFen(const std::string& fen) {
     _status = 0;
     castleRights[0] = castleRights[1] = 0;
 
-    for (int i = 0, pos = 0; i < thefen.length(); i++) {
-        char ch = thefen.at(i);
+    int pos = 0;
+    for (size_t i = 0; i < len; i++) {
+        char ch = fen[i];
 
         if (ch==' ') {
             last = true;
@@ -243,8 +286,8 @@ void chessBoardCore::setFen(const std::string& fen) {
 
         if (last) {
             // enpassant
-            if (ch >= 'a' && ch <= 'h' && i + 1 < thefen.length()) {
-                char ch2 = thefen.at(i + 1);
+            if (ch >= 'a' && ch <= 'h' && i + 1 < len) {
+                char ch2 = fen[i + 1];
                 if (ch2 >= '1' && ch2 <= '8') {
                     enpassant = (7 - (ch2 - '1')) * 8 + (ch - 'a');
                     continue;
@@ -281,7 +324,11 @@ void chessBoardCore::setFen(const std::string& fen) {
         }
 
         if (ch=='/') {
-            std::string str = fen.substr();
+            continue;
+        }
+
+        // Broken FEN, too many squares
+        if (pos >= 64) {
             continue;
         }
 
@@ -297,17 +344,21 @@ void chessBoardCore::setFen(const std::string& fen) {
             ch += 'a' - 'A';
         }
 
-        auto pieceType = PieceType::empty;
-        const char* p = strchr(pieceTypeName, ch);
-        if (p != NULL) {
-            int k = (int)(p - pieceTypeName);
-            pieceType = static_cast<PieceType>(k);
-
-        }
-        if (pieceType != PieceType::empty) {
-            setPiece(pos, Piece(pieceType, side));
-            pieceList_set((Piece *)pieceList, pos, pieceType, side);
+        // Pieces kqrbnp only. Any other char (a NUL inside len too, strchr finds the terminator), a second king
+        // or more pieces than the piece list holds break the FEN, it is marked invalid by having no side
+        const char* p = ch ? strchr(pieceTypeName, ch) : NULL;
+        int k = p ? (int)(p - pieceTypeName) : -1;
+        auto pieceType = k < 0 || k > static_cast<int>(PieceType::pawn) ? PieceType::empty : static_cast<PieceType>(k);
+        if (pieceType == PieceType::empty
+            || (pieceType == PieceType::king && pieceList[static_cast<int>(side)][0].type == PieceType::king)
+            || !pieceList_set((Piece *)pieceList, pos, pieceType, side)) {
+            this->side = Side::none;
+            return;
         }
+
+        setPiece(pos, Piece(pieceType, side));
+        materialKey += materialKeyOf(pieceType, side);
+        hashKey ^= zobrist.piece(pieceType, side, pos);
         pos++;
     }
 
@@ -571,6 +622,189 @@ void chessBoardCore::takeBack(const Hist& hist) {
     pieceList_takeback(hist);
 }
 
+////////////////////////////////////////////////////////////////////////
+// Retro moves
+////////////////////////////////////////////////////////////////////////
+
+static const int straightDirs[4][2] = { { -1, 0 }, { 1, 0 }, { 0, -1 }, { 0, 1 } };
+static const int diagonalDirs[4][2] = { { -1, -1 }, { -1, 1 }, { 1, -1 }, { 1, 1 } };
+static const int knightDirs[8][2] = { { -2, -1 }, { -2, 1 }, { -1, -2 }, { -1, 2 }, { 1, -2 }, { 1, 2 }, { 2, -1 }, { 2, 1 } };
+
+void chessBoardCore::genRetro(RetroMoveList& moveList, Side side, bool uncaptures, bool unpromotions) const {
+    auto sd = static_cast<int>(side);
+    auto lastRow = side == Side::white ? 0 : 7;
+    uncaptures = uncaptures && genRetro_canUncapture(side);
+
+    for (int i = 0; i < 16; i++) {
+        auto piece = pieceList[sd][i];
+        if (piece.isEmpty()) {
+            continue;
+        }
+
+        auto pos = piece.idx, row = ROW(pos), col = COL(pos);
+        auto type = piece.type;
+
+        auto addDirs = [&](const int (*dirs)[2], int dirCnt, bool sliding) {
+            for (int k = 0; k < dirCnt; k++) {
+                for (int r = row + dirs[k][0], c = col + dirs[k][1]; r >= 0 && r < 8 && c >= 0 && c < 8; r += dirs[k][0], c += dirs[k][1]) {
+                    auto from = r * 8 + c;
+                    if (!isEmpty(from)) {
+                        break;
+                    }
+                    genRetro_addMove(moveList, Move(type, side, from, pos), true, uncaptures);
+                    if (!sliding) {
+                        break;
+                    }
+                }
+            }
+        };
+
+        if (type == PieceType::pawn) {
+            genRetro_pawn(moveList, pos, side, uncaptures);
+            continue;
+        }
+
+        if (unpromotions && type != PieceType::king && row == lastRow) {
+            genRetro_unpromotions(moveList, pos, type, side, uncaptures);
+        }
+
+        switch (type) {
+            case PieceType::king:
+                addDirs(straightDirs, 4, false);
+                addDirs(diagonalDirs, 4, false);
+                break;
+            case PieceType::queen:
+                addDirs(straightDirs, 4, true);
+                addDirs(diagonalDirs, 4, true);
+                break;
+            case PieceType::rook:
+                addDirs(straightDirs, 4, true);
+                break;
+            case PieceType::bishop:
+                addDirs(diagonalDirs, 4, true);
+                break;
+            case PieceType::knight:
+                addDirs(knightDirs, 8, false);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+// The piece list of the other side must have a free slot for an un-captured piece
+bool chessBoardCore::genRetro_canUncapture(Side side) const {
+    auto xsd = 1 - static_cast<int>(side);
+    for (int i = 1; i < 16; i++) {
+        if (pieceList[xsd][i].isEmpty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void chessBoardCore::genRetro_addMove(RetroMoveList& moveList, const Move& move, bool quiet, bool uncaptures) const {
+    if (quiet) {
+        moveList.add(move);
+    }
+    if (uncaptures) {
+        auto lastRows = move.dest < 8 || move.dest >= 56;
+        for (int t = static_cast<int>(PieceType::queen); t <= static_cast<int>(PieceType::pawn); t++) {
+            if (t != static_cast<int>(PieceType::pawn) || !lastRows) {
+                moveList.add(move, static_cast<PieceType>(t));
+            }
+        }
+    }
+}
+
+void chessBoardCore::genRetro_pawn(RetroMoveList& moveList, int pos, Side side, bool uncaptures) const {
+    auto d = side == Side::white ? +8 : -8; // backward
+    auto row = ROW(pos + d);
+    if (row < 1 || row > 6) {
+        return;
+    }
+
+    if (isEmpty(pos + d)) {
+        moveList.add(Move(PieceType::pawn, side, pos + d, pos));
+
+        auto from2 = pos + 2 * d;
+        if (ROW(from2) == (side == Side::white ? 6 : 1) && isEmpty(from2)) {
+            moveList.add(Move(PieceType::pawn, side, from2, pos));
+        }
+    }
+
+    if (!uncaptures) {
+        return;
+    }
+
+    auto col = COL(pos);
+    for (int k = -1; k <= 1; k += 2) {
+        auto from = pos + d + k;
+        if (col + k < 0 || col + k > 7 || !isEmpty(from)) {
+            continue;
+        }
+        Move move(PieceType::pawn, side, from, pos);
+        genRetro_addMove(moveList, move, false, true);
+
+        // En passant: the captured pawn went from the square in front of pos to the one behind it
+        if (ROW(pos) == (side == Side::white ? 2 : 5) && isEmpty(pos + d) && isEmpty(pos - d)) {
+            moveList.add(move, PieceType::pawn, true);
+        }
+    }
+}
+
+void chessBoardCore::genRetro_unpromotions(RetroMoveList& moveList, int pos, PieceType type, Side side, bool uncaptures) const {
+    auto d = side == Side::white ? +8 : -8;
+    if (isEmpty(pos + d)) {
+        moveList.add(Move(PieceType::pawn, side, pos + d, pos, type));
+    }
+
+    if (!uncaptures) {
+        return;
+    }
+
+    auto col = COL(pos);
+    for (int k = -1; k <= 1; k += 2) {
+        auto from = pos + d + k;
+        if (col + k >= 0 && col + k <= 7 && isEmpty(from)) {
+            genRetro_addMove(moveList, Move(PieceType::pawn, side, from, pos, type), false, true);
+        }
+    }
+}
+
+// Hist of the retro move as it was made forward
+void chessBoardCore::unmake_prepare(const RetroMove& retroMove, Hist& hist) const {
+    auto& move = retroMove.move;
+    hist.move = move;
+    hist.enpassant = retroMove.enpassant ? move.dest : -1;
+    hist.status = _status;
+    hist.castleRights[0] = castleRights[0];
+    hist.castleRights[1] = castleRights[1];
+
+    if (retroMove.cap == PieceType::empty) {
+        hist.cap.setEmpty();
+    } else {
+        auto capPos = move.dest + (retroMove.enpassant ? (move.side == Side::white ? +8 : -8) : 0);
+        hist.cap.set(retroMove.cap, getXSide(move.side), capPos);
+    }
+}
+
+void chessBoardCore::unmake(const RetroMove& retroMove, Hist& hist) {
+    unmake_prepare(retroMove, hist);
+    auto curEnpassant = enpassant;
+    takeBack(hist);
+    hist.enpassant = curEnpassant;
+}
+
+void chessBoardCore::remake(const Hist& hist) {
+    Hist h;
+    make(hist.move, h);
+    enpassant = hist.enpassant;
+    _status = hist.status;
+    castleRights[0] = hist.castleRights[0];
+    castleRights[1] = hist.castleRights[1];
+}
+
 
 void chessBoardCore::pieceList_reset(Piece *pieceList) {
     for(int i = 0; i < 16; i++) {
@@ -673,6 +907,8 @@ bool chessBoardCore::pieceList_make(const Hist& hist) {
         }
         for (int t = 0, sd = static_cast<int>(hist.cap.side); t < 16; t++) {
             if (pieceList[sd][t].idx == capPos && pieceList[sd][t].type != PieceType::empty) {
+                materialKey -= materialKeyOf(pieceList[sd][t].type, hist.cap.side);
+                hashKey ^= zobrist.piece(pieceList[sd][t].type, hist.cap.side, capPos);
                 pieceList[sd][t].type = PieceType::empty;
                 ok = true;
                 break;
@@ -685,10 +921,13 @@ bool chessBoardCore::pieceList_make(const Hist& hist) {
     for (int t = 0, sd = static_cast<int>(hist.move.side); t < 16; t++) {
         if (pieceList[sd][t].idx == hist.move.from && pieceList[sd][t].type != PieceType::empty) {
             pieceList[sd][t].idx = hist.move.dest;
+            hashKey ^= zobrist.piece(pieceList[sd][t].type, hist.move.side, hist.move.from);
 
             if (hist.move.promote != PieceType::empty) {
+                materialKey += materialKeyOf(hist.move.promote, hist.move.side) - materialKeyOf(pieceList[sd][t].type, hist.move.side);
                 pieceList[sd][t].type = hist.move.promote;
             }
+            hashKey ^= zobrist.piece(pieceList[sd][t].type, hist.move.side, hist.move.dest);
             return true;
         }
     }
@@ -700,9 +939,12 @@ bool chessBoardCore::pieceList_takeback(const Hist& hist) {
     for (int t = 0, sd = static_cast<int>(hist.move.side); t < 16; t++) {
         if (pieceList[sd][t].idx == hist.move.dest && pieceList[sd][t].type != PieceType::empty) {
             pieceList[sd][t].idx = hist.move.from;
+            hashKey ^= zobrist.piece(pieceList[sd][t].type, hist.move.side, hist.move.dest);
             if (hist.move.promote != PieceType::empty) {
+                materialKey += materialKeyOf(PieceType::pawn, hist.move.side) - materialKeyOf(pieceList[sd][t].type, hist.move.side);
                 pieceList[sd][t].type = PieceType::pawn;
             }
+            hashKey ^= zobrist.piece(pieceList[sd][t].type, hist.move.side, hist.move.from);
             ok = true;
             break;
         }
@@ -716,6 +958,7 @@ bool chessBoardCore::pieceList_takeback(const Hist& hist) {
     for (int t = 0, sd = static_cast<int>(hist.cap.side); t < 16; t++) {
         if (pieceList[sd][t].type == PieceType::empty) {
             pieceList[sd][t] = hist.cap;
+            materialKey += materialKeyOf(hist.cap.type, hist.cap.side);
 
             pieceList[sd][t].idx = hist.move.dest;
 
@@ -723,6 +966,7 @@ bool chessBoardCore::pieceList_takeback(const Hist& hist) {
                 assert(hist.move.type == PieceType::pawn && hist.cap.type == PieceType::pawn);
                 pieceList[sd][t].idx += hist.move.dest > 32 ? -8 : +8;
             }
+            hashKey ^= zobrist.piece(hist.cap.type, hist.cap.side, pieceList[sd][t].idx);
 
             return true;
         }
@@ -748,6 +992,8 @@ bool chessBoardCore::pieceList_setupBoard(const Piece *thePieceList) {
     if (thePieceList) {
         memcpy(pieceList, thePieceList, sizeof(pieceList));
     }
+    materialKey = pieceList_materialKey((const Piece *)pieceList);
+    hashKey = pieceList_hashKey((const Piece *)pieceList);
 
     for (int sd = 0; sd < 2; sd++) {
         for(int i = 0; i < 16; i++) {
@@ -766,6 +1012,26 @@ bool chessBoardCore::pieceList_setupBoard(const Piece *thePieceList) {
 }
 
 
+u64 chessBoardCore::pieceList_materialKey(const Piece *pieceList) {
+    u64 key = 0;
+    for(int i = 0; i < 32; i++) {
+        if (!pieceList[i].isEmpty()) {
+            key += materialKeyOf(pieceList[i].type, pieceList[i].side);
+        }
+    }
+    return key;
+}
+
+u64 chessBoardCore::pieceList_hashKey(const Piece *pieceList) {
+    u64 key = 0;
+    for(int i = 0; i < 32; i++) {
+        if (!pieceList[i].isEmpty()) {
+            key ^= zobrist.piece(pieceList[i].type, pieceList[i].side, pieceList[i].idx);
+        }
+    }
+    return key;
+}
+
 Side chessBoardCore::strongSide(const Piece *pieceList) {
     int mat[] = { 0, 0};
     for (int sd = 0, d = 0; sd < 2; sd++, d = 16) {
@@ -1386,6 +1652,8 @@ void chessBoard::takeBack(const Hist& hist) {
 bool chessBoard::setup(const std::vector<Piece> pieceVec, Side _side, Squares _enpassant) {
     pieceList_reset((Piece *)pieceList);
     reset();
+    materialKey = 0;
+    hashKey = 0;
 
     side = _side;
     for (auto && p : pieceVec) {
@@ -1398,6 +1666,8 @@ bool chessBoard::setup(const std::vector<Piece> pieceVec, Side _side, Squares _e
         }
         setPiece(p.idx, p);
         pieceList_set((Piece *)pieceList, p.idx, p.type, p.side);
+        materialKey += materialKeyOf(p.type, p.side);
+        hashKey ^= zobrist.piece(p.type, p.side, p.idx);
     }
 
     enpassant = static_cast<int>(_enpassant);
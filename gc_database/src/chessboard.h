@@ -187,12 +187,91 @@ namespace chess {
 
     };
 
+    /*
+     * Move leading into the current position (un-move). The piece of move.side stands on move.dest now,
+     * it goes back to move.from (as a pawn for un-promotions) and cap (of the other side) comes back
+     * to move.dest, or to the square behind it for en passant
+     */
+    class RetroMove {
+    public:
+        Move move;
+        PieceType cap;
+        bool enpassant;
+
+        void set(const Move& _move, PieceType _cap = PieceType::empty, bool _enpassant = false) {
+            move = _move;
+            cap = _cap;
+            enpassant = _enpassant;
+        }
+
+        std::string toString() const {
+            std::ostringstream stringStream;
+            stringStream << move.toString();
+            if (cap != PieceType::empty) {
+                stringStream << "x" << Piece(cap, Side::white).toString() << (enpassant ? "ep" : "");
+            }
+            return stringStream.str();
+        }
+    };
+
+#define MaxRetroMoveNumber 1024
+
+    class RetroMoveList {
+    public:
+        RetroMove list[MaxRetroMoveNumber];
+        int end;
+
+        RetroMoveList() {
+            reset();
+        }
+
+        void reset() {
+            end = 0;
+        }
+
+        void add(const Move& move, PieceType cap = PieceType::empty, bool enpassant = false) {
+            assert(end < MaxRetroMoveNumber);
+            list[end].set(move, cap, enpassant);
+            end++;
+        }
+    };
+
+
+    /*
+     * Random keys for hashing positions, made once at startup by a fixed seed
+     */
+    class chessZobrist {
+    public:
+        u64 pieces[2][6][64];
+        u64 sides[2];
+        u64 enpassants[64];
+
+        chessZobrist();
+
+        u64 piece(PieceType type, Side side, int pos) const {
+            return pieces[static_cast<int>(side)][static_cast<int>(type)][pos];
+        }
+
+        // Key of a position from hashKey of its board, the side to move and the en passant square
+        u64 positionKey(u64 hashKey, Side side, int enpassant) const {
+            return hashKey ^ sides[static_cast<int>(side)] ^ (enpassant > 0 ? enpassants[enpassant] : 0);
+        }
+    };
+
+    extern const chessZobrist zobrist;
 
     class chessBoardCore {
     public:
         Piece pieceList[2][16];
         Side side;
 
+        // Piece counts of the piece list, 4 bits for each type of each side, kept by make/takeBack/setFen/setup
+        // and pieceList_setupBoard. Call pieceList_setupBoard after changing the piece list directly
+        u64 materialKey;
+
+        // Zobrist key of pieces on squares (side and en passant are not in), kept the same way as materialKey
+        u64 hashKey;
+
         int enpassant;
         int _status;
         int8_t castleRights[2];
@@ -205,6 +284,8 @@ namespace chess {
             castleRights[0] = fromBoard.castleRights[0];
             castleRights[1] = fromBoard.castleRights[1];
             memcpy(&pieceList, &fromBoard.pieceList, sizeof(pieceList));
+            materialKey = fromBoard.materialKey;
+            hashKey = fromBoard.hashKey;
         }
 
         virtual void setPiece(int pos, Piece piece) = 0;
@@ -228,6 +309,15 @@ namespace chess {
         virtual void make(const Move& move, Hist& hist);
         virtual void takeBack(const Hist& hist);
 
+        // Un-moves of side (the side which has just moved), pseudo legal: callers check the king of the other
+        // side is not in check after unmake. Un-captures and un-promotions change the material, they could be
+        // left out. Castles are not generated, castle rights are kept as they are
+        virtual void genRetro(RetroMoveList& moveList, Side side, bool uncaptures = true, bool unpromotions = true) const;
+
+        // Takes back a retro move, hist keeps the current state for remake
+        virtual void unmake(const RetroMove& retroMove, Hist& hist);
+        virtual void remake(const Hist& hist);
+
         virtual bool isPositionValid(int pos) const {
             return pos >= 0 && pos < 64;
         }
@@ -246,13 +336,23 @@ namespace chess {
         virtual int findKing(Side side) const;
         virtual void clearCastleRights(int rookPos, Side rookSide);
 
+        bool genRetro_canUncapture(Side side) const;
+        void genRetro_addMove(RetroMoveList& moveList, const Move& move, bool quiet, bool uncaptures) const;
+        void genRetro_pawn(RetroMoveList& moveList, int pos, Side side, bool uncaptures) const;
+        void genRetro_unpromotions(RetroMoveList& moveList, int pos, PieceType type, Side side, bool uncaptures) const;
+
+        void unmake_prepare(const RetroMove& retroMove, Hist& hist) const;
+
     public:
         chessBoardCore();
 
         std::string toString() const;
         bool isValid() const;
+        // Can be probed: setFen read it, both kings are there and the side not to move is not in check
+        bool isLegal() const;
 
         void setFen(const std::string& fen);
+        void setFen(const char* fen, size_t len);
         std::string getFen(int halfCount = 0, int fullMoveCount = 1) const;
         void show() const;
 
@@ -267,6 +367,17 @@ namespace chess {
 
         static Side strongSide(const Piece *pieceList);
 
+        static u64 materialKeyOf(PieceType type, Side side) {
+            return 1ULL << ((static_cast<int>(side) * 8 + static_cast<int>(type)) * 4);
+        }
+        static u64 pieceList_materialKey(const Piece *pieceList);
+        static u64 pieceList_hashKey(const Piece *pieceList);
+
+        // Same material with colours swapped
+        static u64 flipMaterialKey(u64 key) {
+            return key >> 32 | key << 32;
+        }
+
         bool pieceList_isDraw() const {
             return pieceList_isDraw((const Piece *)pieceList);
         }
@@ -278,8 +389,57 @@ namespace chess {
     };
 
 
+    /*
+     * Base of concrete boards. Functions here call the ones of Board directly, thus with a final Board
+     * they are resolved at compile time and could be inlined. The virtual functions of chessBoardCore
+     * still work for callers having chessBoardCore only
+     */
+    template <class Board>
+    class chessBoardBase : public chessBoardCore {
+    public:
+        bool isIncheck(Side beingAttackedSide) const {
+            auto& board = static_cast<const Board&>(*this);
+            return board.beAttacked(board.findKing(beingAttackedSide), getXSide(beingAttackedSide));
+        }
+
+        void genLegalOnly(MoveList& moveList, Side attackerSide, bool captureOnly = false) {
+            auto& board = static_cast<Board&>(*this);
+            board.gen(moveList, attackerSide, captureOnly);
+
+            Hist hist;
+            int j = 0;
+            for (int i = 0; i < moveList.end; i++) {
+                board.make(moveList.list[i], hist);
+                if (!board.isIncheck(attackerSide)) {
+                    moveList.list[j] = moveList.list[i];
+                    j++;
+                }
+                board.takeBack(hist);
+            }
+            moveList.end = j;
+        }
+
+        void unmake(const RetroMove& retroMove, Hist& hist) {
+            auto& board = static_cast<Board&>(*this);
+            unmake_prepare(retroMove, hist);
+            auto curEnpassant = enpassant;
+            board.takeBack(hist);
+            hist.enpassant = curEnpassant;
+        }
+
+        void remake(const Hist& hist) {
+            auto& board = static_cast<Board&>(*this);
+            Hist h;
+            board.make(hist.move, h);
+            enpassant = hist.enpassant;
+            _status = hist.status;
+            castleRights[0] = hist.castleRights[0];
+            castleRights[1] = hist.castleRights[1];
+        }
+    };
+
     ///////////////////////////////////////////////////
-    class chessBoard : public chessBoardCore {
+    class chessBoard final : public chessBoardBase<chessBoard> {
     protected:
         Piece pieces[64];
 
@@ -327,5 +487,7 @@ namespace chess {
 
 } // namespace chess
 
+#include "chessbitboard.h"
+
 #endif /* chessBoard_h */
 
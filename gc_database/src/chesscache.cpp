@@ -0,0 +1,146 @@
+#include "chess.h"
+#include "chesscache.h"
+
+using namespace chess;
+
+chessBlockCache::chessBlockCache(i64 _byteBudget) {
+    setSize(_byteBudget);
+}
+
+chessBlockCache::~chessBlockCache() {
+    for (auto && shard : shards) {
+        shard.reset(0);
+    }
+}
+
+void chessBlockCache::setSize(i64 _byteBudget) {
+    auto budget = MAX(0, _byteBudget);
+    byteBudget.store(budget, std::memory_order_relaxed);
+    auto capacity = (int)(budget / chess_SIZE_COMPRESS_BLOCK / chess_BLOCK_CACHE_SHARDS);
+    for (auto && shard : shards) {
+        std::lock_guard<std::mutex> thelock(shard.mtx);
+        shard.reset(capacity);
+    }
+}
+
+void chessBlockCache::clear() {
+    setSize(getSize());
+}
+
+// Memory of a shard is allocated when it is used the first time
+void chessBlockCache::Shard::reset(int _capacity) {
+    if (data) {
+        free(data);
+        data = nullptr;
+    }
+    slotMap.clear();
+    keys.clear();
+    refs.clear();
+    lens.clear();
+    capacity = _capacity;
+    used = hand = 0;
+}
+
+int chessBlockCache::get(u32 fileId, int sd, i64 blockIdx, char* pDest) {
+    if (!isEnabled()) {
+        return -1;
+    }
+
+    auto key = makeKey(fileId, sd, blockIdx);
+    auto& shard = getShard(key);
+
+    std::lock_guard<std::mutex> thelock(shard.mtx);
+    auto it = shard.slotMap.find(key);
+    if (it == shard.slotMap.end()) {
+        shard.misses.fetch_add(1, std::memory_order_relaxed);
+        return -1;
+    }
+
+    auto slot = it->second;
+    auto len = shard.lens[slot];
+    shard.refs[slot] = 1;
+    memcpy(pDest, shard.data + (i64)slot * chess_SIZE_COMPRESS_BLOCK, len);
+    shard.hits.fetch_add(1, std::memory_order_relaxed);
+    return len;
+}
+
+void chessBlockCache::put(u32 fileId, int sd, i64 blockIdx, const char* pData, int len) {
+    if (!isEnabled() || len <= 0 || len > chess_SIZE_COMPRESS_BLOCK) {
+        return;
+    }
+
+    auto key = makeKey(fileId, sd, blockIdx);
+    auto& shard = getShard(key);
+
+    std::lock_guard<std::mutex> thelock(shard.mtx);
+    if (shard.capacity <= 0 || shard.slotMap.find(key) != shard.slotMap.end()) {
+        return;
+    }
+
+    if (shard.data == nullptr) {
+        shard.data = (char*)malloc((i64)shard.capacity * chess_SIZE_COMPRESS_BLOCK);
+        if (shard.data == nullptr) {
+            shard.capacity = 0;
+            return;
+        }
+        shard.keys.resize(shard.capacity);
+        shard.refs.resize(shard.capacity);
+        shard.lens.resize(shard.capacity);
+    }
+
+    int slot;
+    if (shard.used < shard.capacity) {
+        slot = shard.used++;
+    } else {
+        // CLOCK: give blocks used since the last sweep a second chance
+        while (shard.refs[shard.hand]) {
+            shard.refs[shard.hand] = 0;
+            shard.hand = (shard.hand + 1) % shard.capacity;
+        }
+        slot = shard.hand;
+        shard.hand = (shard.hand + 1) % shard.capacity;
+        shard.slotMap.erase(shard.keys[slot]);
+        shard.evictions.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    shard.keys[slot] = key;
+    shard.refs[slot] = 0;
+    shard.lens[slot] = len;
+    memcpy(shard.data + (i64)slot * chess_SIZE_COMPRESS_BLOCK, pData, len);
+    shard.slotMap[key] = slot;
+}
+
+chessBlockCacheStats chessBlockCache::getStats() const {
+    chessBlockCacheStats stats;
+    memset(&stats, 0, sizeof(stats));
+
+    for (auto && shard : shards) {
+        stats.hits += shard.hits.load(std::memory_order_relaxed);
+        stats.misses += shard.misses.load(std::memory_order_relaxed);
+        stats.evictions += shard.evictions.load(std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> thelock(shard.mtx);
+        stats.blockCnt += shard.used;
+        stats.capacity += shard.capacity;
+    }
+    return stats;
+}
+
+void chessBlockCache::resetStats() {
+    for (auto && shard : shards) {
+        shard.hits = shard.misses = shard.evictions = 0;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////
+////////////////////////////////////////////////////////////////////////
+
+// Number of sets is a power of two
+chessScoreCache::chessScoreCache(int entryCnt) {
+    u64 setCnt = 1;
+    while (setCnt * 2 * 4 <= (u64)MAX(entryCnt, 4)) {
+        setCnt *= 2;
+    }
+    setMask = setCnt - 1;
+    entries.assign(setCnt * 4, 0);
+}
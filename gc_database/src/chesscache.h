@@ -0,0 +1,149 @@
+#ifndef chessCache_h
+#define chessCache_h
+
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "chess.h"
+
+namespace chess {
+
+    class chessBlockCacheStats {
+    public:
+        u64         hits, misses, evictions;
+        i64         blockCnt, capacity;    // blocks in use / max blocks
+
+        double hitRate() const {
+            auto total = hits + misses;
+            return total ? (double)hits / total : 0;
+        }
+
+        std::string toString() const {
+            std::ostringstream stringStream;
+            stringStream << "hits: " << hits << ", misses: " << misses << ", hit rate: " << hitRate()
+                         << ", evictions: " << evictions << ", blocks: " << blockCnt << "/" << capacity;
+            return stringStream.str();
+        }
+    };
+
+    /*
+     * Decompressed blocks of all files of a chessDb, identified by (file, side, block index)
+     * Blocks are split into shards by their keys to reduce lock contention, each shard
+     * evicts by CLOCK (second chance) when it is full
+     */
+    class chessBlockCache {
+    public:
+        chessBlockCache(i64 byteBudget = chess_BLOCK_CACHE_SIZE);
+        ~chessBlockCache();
+
+        // 0 to disable
+        void    setSize(i64 byteBudget);
+        i64     getSize() const { return byteBudget.load(std::memory_order_relaxed); }
+
+        bool    isEnabled() const { return byteBudget.load(std::memory_order_relaxed) > 0; }
+
+        // Copy the block into pDest, return its length or -1 if it is not in the cache
+        int     get(u32 fileId, int sd, i64 blockIdx, char* pDest);
+        void    put(u32 fileId, int sd, i64 blockIdx, const char* pData, int len);
+
+        void    clear();
+
+        chessBlockCacheStats getStats() const;
+        void    resetStats();
+
+    private:
+        class Shard {
+        public:
+            mutable std::mutex mtx;
+            std::unordered_map<u64, int> slotMap;
+
+            std::vector<u64> keys;
+            std::vector<u8>  refs;
+            std::vector<int> lens;
+            char*       data = nullptr;
+
+            int         capacity = 0, used = 0, hand = 0;
+
+            std::atomic<u64> hits { 0 }, misses { 0 }, evictions { 0 };
+
+            void    reset(int capacity);
+        };
+
+        static u64 makeKey(u32 fileId, int sd, i64 blockIdx) {
+            return (u64)fileId << 33 | (u64)sd << 32 | (u64)blockIdx;
+        }
+
+        Shard&  getShard(u64 key) {
+            key ^= key >> 29; key *= 0xbf58476d1ce4e5b9ULL; key ^= key >> 32;
+            return shards[key % chess_BLOCK_CACHE_SHARDS];
+        }
+
+        std::atomic<i64> byteBudget;    // read by probing threads while setSize may change it
+        Shard   shards[chess_BLOCK_CACHE_SHARDS];
+    };
+
+    class chessScoreCacheStats {
+    public:
+        u64         hits, misses;
+        i64         entryCnt, cacheCnt;     // entries of each cache / caches (threads) in use
+
+        double hitRate() const {
+            auto total = hits + misses;
+            return total ? (double)hits / total : 0;
+        }
+
+        std::string toString() const {
+            std::ostringstream stringStream;
+            stringStream << "score cache hits: " << hits << ", misses: " << misses << ", hit rate: " << hitRate()
+                         << ", entries: " << entryCnt << " x " << cacheCnt << " threads";
+            return stringStream.str();
+        }
+    };
+
+    /*
+     * Scores of positions by their Zobrist keys (chessZobrist::positionKey), owned by one thread thus
+     * no locks. Sets of 4 entries, a new entry goes first in its set and the last one is dropped.
+     * An entry keeps the high 48 bits of the key and the score in the low 16 bits
+     */
+    class chessScoreCache {
+    public:
+        chessScoreCache(int entryCnt);
+
+        bool    get(u64 key, int& score) {
+            auto set = &entries[(key & setMask) * 4];
+            for (int i = 0; i < 4; i++) {
+                if ((set[i] ^ key) >> 16 == 0 && set[i]) {
+                    score = (i16)(u16)set[i];
+                    count(hits);
+                    return true;
+                }
+            }
+            count(misses);
+            return false;
+        }
+
+        void    put(u64 key, int score) {
+            auto set = &entries[(key & setMask) * 4];
+            set[3] = set[2]; set[2] = set[1]; set[1] = set[0];
+            set[0] = (key & ~0xffffULL) | (u16)(i16)score;
+        }
+
+        int     getEntryCnt() const { return (int)entries.size(); }
+
+        // Written by the owner only, other threads read them for stats
+        std::atomic<u64> hits { 0 }, misses { 0 };
+
+    private:
+        std::vector<u64> entries;
+        u64     setMask;
+
+        static void count(std::atomic<u64>& counter) {
+            counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+    };
+
+} // namespace chess
+
+#endif /* chessCache_h */
@@ -0,0 +1,204 @@
+#include <fstream>
+#include <filesystem>
+
+#include "chess.h"
+#include "chesscatalog.h"
+
+using namespace chess;
+
+bool chessCatalog::setRelativePath(char* dest, const std::string& folder, const std::string& path) {
+    assert(path.compare(0, folder.size(), folder) == 0);
+    auto relativePath = path.substr(folder.size());
+    if (relativePath.size() >= chess_CATALOG_PATH_SIZE) {
+        return false;
+    }
+    memset(dest, 0, chess_CATALOG_PATH_SIZE);
+    memcpy(dest, relativePath.c_str(), relativePath.size());
+    return true;
+}
+
+// Folders should not be changed while the catalog is being written
+bool chessCatalog::create(const std::string& folder) {
+    std::vector<std::string> dirPaths { folder };
+    std::error_code ec;
+    for (std::filesystem::recursive_directory_iterator it(folder, ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->is_directory()) {
+            dirPaths.push_back(it->path().string());
+        }
+    }
+    if (ec) {
+        if (chessVerbose) {
+            std::cerr << "Error: cannot list " << folder << std::endl;
+        }
+        return false;
+    }
+
+    std::vector<chessCatalogDir> dirs(dirPaths.size());
+    for (size_t i = 0; i < dirPaths.size(); i++) {
+        if (!setRelativePath(dirs[i].path, folder, dirPaths[i])) {
+            return false;
+        }
+    }
+
+    std::vector<chessCatalogEntry> entries;
+    std::vector<std::vector<u32>> blockTables;
+    for (auto && path : listdir(folder)) {
+        if (!chessFile::knownExtension(path)) {
+            continue;
+        }
+
+        chessCatalogEntry entry;
+        memset(&entry, 0, sizeof(entry));
+
+        std::ifstream file(path, std::ios::binary);
+        chessFileHeader header;
+        bool r = setRelativePath(entry.path, folder, path) && getFileStat(path, entry.fileSize, entry.modifiedTime)
+                 && file.read(entry.header, chess_HEADER_SIZE) && header.readFile(entry.header, chess_HEADER_SIZE) && header.isValid();
+
+        std::vector<u32> blockTable;
+        if (r && (header.property & chess_PROP_COMPRESSED)) {
+            int idxArr[32], pieceCount[2][7];
+            i64 idxMult[32];
+            auto size = chessFile::parseAttr(header.name, idxArr, idxMult, (int*)pieceCount, header.order, header.getVersion());
+            blockTable.resize((size + chess_SIZE_COMPRESS_BLOCK - 1) / chess_SIZE_COMPRESS_BLOCK);
+            r = size > 0 && file.read((char*)blockTable.data(), blockTable.size() * sizeof(u32));
+        }
+
+        if (!r) {
+            if (chessVerbose) {
+                std::cerr << "Error: cannot read " << path << std::endl;
+            }
+            return false;
+        }
+        entry.blockCnt = (u32)blockTable.size();
+        entries.push_back(entry);
+        blockTables.push_back(std::move(blockTable));
+    }
+
+    chessCatalogHeader catalogHeader;
+    memset(&catalogHeader, 0, sizeof(catalogHeader));
+    catalogHeader.signature = chess_CATALOG_SIGNATURE;
+    catalogHeader.version = chess_CATALOG_VERSION;
+    catalogHeader.dirCnt = (u32)dirs.size();
+    catalogHeader.entryCnt = (u32)entries.size();
+
+    // Block tables follow entries, each one starts at 8 bytes
+    i64 offset = sizeof(catalogHeader) + dirs.size() * sizeof(chessCatalogDir) + entries.size() * sizeof(chessCatalogEntry);
+    for (auto && entry : entries) {
+        entry.blockTableOffset = offset;
+        offset += (entry.blockCnt * sizeof(u32) + 7) & ~7;
+    }
+    catalogHeader.size = offset;
+
+    auto path = getPath(folder), tmpPath = path + ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+        file.write((const char*)&catalogHeader, sizeof(catalogHeader));
+        file.write((const char*)dirs.data(), dirs.size() * sizeof(chessCatalogDir));
+        file.write((const char*)entries.data(), entries.size() * sizeof(chessCatalogEntry));
+        const char padding[8] = { 0 };
+        for (auto && blockTable : blockTables) {
+            auto sz = blockTable.size() * sizeof(u32);
+            file.write((const char*)blockTable.data(), sz);
+            file.write(padding, ((sz + 7) & ~7) - sz);
+        }
+        if (!file) {
+            if (chessVerbose) {
+                std::cerr << "Error: cannot write " << tmpPath << std::endl;
+            }
+            return false;
+        }
+    }
+
+    std::filesystem::rename(tmpPath, path, ec);
+    if (ec) {
+        std::filesystem::remove(tmpPath, ec);
+        if (chessVerbose) {
+            std::cerr << "Error: cannot write " << path << std::endl;
+        }
+        return false;
+    }
+
+    // The catalog changes the time of the folder, times are taken after it is in place.
+    // Rewriting its content changes no folder
+    for (auto && dir : dirs) {
+        i64 size;
+        if (!getFileStat(folder + dir.path, size, dir.modifiedTime)) {
+            return false;
+        }
+    }
+    std::fstream file(path, std::ios::binary | std::ios::in | std::ios::out);
+    file.seekp(sizeof(catalogHeader));
+    file.write((const char*)dirs.data(), dirs.size() * sizeof(chessCatalogDir));
+    return (bool)file;
+}
+
+bool chessCatalog::open(const std::string& _folder) {
+    close();
+    folder = _folder;
+    data = mapFile(getPath(folder), length);
+    if (data == nullptr) {
+        return false;
+    }
+
+    if (!isValid()) {
+        if (chessVerbose) {
+            std::cerr << "Error: broken catalog " << getPath(folder) << std::endl;
+        }
+        close();
+        return false;
+    }
+
+    auto dirs = getDirs();
+    for (u32 i = 0; i < getHeader()->dirCnt; i++) {
+        i64 size, modifiedTime;
+        if (!getFileStat(folder + dirs[i].path, size, modifiedTime) || modifiedTime != dirs[i].modifiedTime) {
+            if (chessVerbose) {
+                std::cerr << "Catalog is out of date: " << getPath(folder) << std::endl;
+            }
+            close();
+            return false;
+        }
+    }
+    return true;
+}
+
+void chessCatalog::close() {
+    unmapFile(data, length);
+    data = nullptr;
+    length = 0;
+}
+
+bool chessCatalog::isValid() const {
+    if (length < (i64)sizeof(chessCatalogHeader)) {
+        return false;
+    }
+
+    auto header = getHeader();
+    if (header->signature != chess_CATALOG_SIGNATURE || header->version != chess_CATALOG_VERSION || header->size != length
+        || (i64)sizeof(chessCatalogHeader) + header->dirCnt * (i64)sizeof(chessCatalogDir) + header->entryCnt * (i64)sizeof(chessCatalogEntry) > length) {
+        return false;
+    }
+
+    auto dirs = getDirs();
+    for (u32 i = 0; i < header->dirCnt; i++) {
+        if (dirs[i].path[chess_CATALOG_PATH_SIZE - 1]) {
+            return false;
+        }
+    }
+
+    auto entries = getEntries();
+    for (u32 i = 0; i < header->entryCnt; i++) {
+        auto& entry = entries[i];
+        if (entry.path[chess_CATALOG_PATH_SIZE - 1] || entry.blockTableOffset % sizeof(u32)
+            || entry.blockTableOffset < 0 || entry.blockTableOffset + entry.blockCnt * (i64)sizeof(u32) > length) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool chessCatalog::isUpToDate(const chessCatalogEntry& entry) const {
+    i64 size, modifiedTime;
+    return getFileStat(getPath(entry), size, modifiedTime) && size == entry.fileSize && modifiedTime == entry.modifiedTime;
+}
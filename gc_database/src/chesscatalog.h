@@ -0,0 +1,87 @@
+#ifndef chessCatalog_h
+#define chessCatalog_h
+
+#include <string>
+#include <vector>
+
+#include "chess.h"
+
+namespace chess {
+
+#define chess_CATALOG_NAME          "catalog.gtc"
+#define chess_CATALOG_SIGNATURE     0x31435447      // GTC1
+#define chess_CATALOG_VERSION       1
+#define chess_CATALOG_PATH_SIZE     120
+
+    // Records of a catalog file, as they are on disk
+    class chessCatalogHeader {
+    public:
+        u32     signature, version;
+        u32     dirCnt, entryCnt;
+        i64     size;                   // whole catalog file
+        i64     reserved;
+    };
+
+    // The folder ("") and its subfolders, a file added or removed changes the time of its folder
+    class chessCatalogDir {
+    public:
+        char    path[chess_CATALOG_PATH_SIZE];     // relative to the folder
+        i64     modifiedTime;
+    };
+
+    // A side file
+    class chessCatalogEntry {
+    public:
+        char    path[chess_CATALOG_PATH_SIZE];     // relative to the folder, such as /kqkw.zmt
+        i64     fileSize, modifiedTime;
+        i64     blockTableOffset;                   // from the start of the catalog
+        u32     blockCnt, reserved;
+        char    header[chess_HEADER_SIZE];          // as in the file
+    };
+
+    /*
+     * Catalog of a folder: paths, sizes, modified times, headers and block tables of all side files,
+     * written once by create and read back by one mapping thus a chessDb could be set up without
+     * listing folders nor opening files. A catalog is not used when any of its folders has changed,
+     * an entry is not used when the size or the modified time of its file has changed
+     */
+    class chessCatalog {
+    public:
+        ~chessCatalog() { close(); }
+
+        static std::string getPath(const std::string& folder) { return folder + "/" + chess_CATALOG_NAME; }
+
+        // Write the catalog of the folder (and its subfolders), the old one is replaced
+        static bool create(const std::string& folder);
+
+        // Map the catalog of the folder, false if there is none, it is broken or out of date
+        bool    open(const std::string& folder);
+        void    close();
+
+        int     getEntryCnt() const { return data ? (int)getHeader()->entryCnt : 0; }
+        const chessCatalogEntry& getEntry(int i) const { return getEntries()[i]; }
+        const u32* getBlockTable(const chessCatalogEntry& entry) const { return (const u32*)(data + entry.blockTableOffset); }
+
+        std::string getPath(const chessCatalogEntry& entry) const { return folder + entry.path; }
+
+        // The file has the same size and modified time as when the catalog was written
+        bool    isUpToDate(const chessCatalogEntry& entry) const;
+
+    private:
+        const chessCatalogHeader* getHeader() const { return (const chessCatalogHeader*)data; }
+        const chessCatalogDir* getDirs() const { return (const chessCatalogDir*)(data + sizeof(chessCatalogHeader)); }
+        const chessCatalogEntry* getEntries() const { return (const chessCatalogEntry*)(getDirs() + getHeader()->dirCnt); }
+
+        bool    isValid() const;
+
+        static bool setRelativePath(char* dest, const std::string& folder, const std::string& path);
+
+    private:
+        std::string folder;
+        char*   data = nullptr;
+        i64     length = 0;
+    };
+
+} // namespace chess
+
+#endif /* chessCatalog_h */
@@ -1,3 +1,7 @@
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+
 #include "chess.h"
 #include "chessDb.h"
 #include "chessKey.h"
@@ -5,6 +9,13 @@
 using namespace chess;
 
 chessDb::chessDb() {
+    pendingLoadCnt = 0;
+    pendingDeriveCnt = 0;
+    memoryBudget = chess_SMART_MEMORY_BUDGET;
+    memoryUsed = 0;
+    useCatalog = true;
+    scoreCacheSize = chess_SCORE_CACHE_SIZE;
+    newScoreCacheGeneration();
 }
 
 chessDb::~chessDb() {
@@ -12,18 +23,113 @@ chessDb::~chessDb() {
 }
 
 void chessDb::closeAll() {
+    waitForPreload();
+    preloadPool.reset();
+    waitForDerive();
+    derivePool.reset();
+
     for (auto && chessFile : chessFileVec) {
         delete chessFile;
     }
     folders.clear();
     chessFileVec.clear();
     nameMap.clear();
+    materialTable.clear();
+    blockCache.clear();
+    memoryUsed = 0;
+    newScoreCacheGeneration();
 }
 
 void chessDb::removeAllBuffers() {
+    waitForPreload();
+    waitForDerive();
     for (auto && chessFile : chessFileVec) {
         chessFile->removeBuffers();
     }
+    blockCache.clear();
+    memoryUsed = 0;
+}
+
+void chessDb::setBlockCacheSize(i64 byteBudget) {
+    blockCache.setSize(byteBudget);
+}
+
+chessBlockCacheStats chessDb::getBlockCacheStats() const {
+    return blockCache.getStats();
+}
+
+void chessDb::resetBlockCacheStats() {
+    blockCache.resetStats();
+}
+
+void chessDb::setScoreCacheSize(int entryCnt) {
+    scoreCacheSize = MAX(0, entryCnt);
+    newScoreCacheGeneration();
+}
+
+// Generations are unique for all chessDb, thus a thread never takes the cache of another one
+void chessDb::newScoreCacheGeneration() {
+    static std::atomic<u64> lastGeneration { 0 };
+    scoreCacheGeneration = ++lastGeneration;
+
+    std::lock_guard<std::mutex> thelock(scoreCacheMutex);
+    scoreCaches.clear();
+}
+
+// A thread keeps a cache for each chessDb (generation) it probes. The last used one goes first, caches
+// dropped by their chessDb (new generation, destroyed chessDb) are removed when the thread makes a new one
+chessScoreCache* chessDb::getThreadScoreCache() {
+    class ThreadScoreCache {
+    public:
+        u64 generation = 0;
+        std::shared_ptr<chessScoreCache> cache;
+    };
+    static thread_local std::vector<ThreadScoreCache> threadScoreCaches;
+
+    auto generation = scoreCacheGeneration.load(std::memory_order_acquire);
+    for (size_t i = 0; i < threadScoreCaches.size(); i++) {
+        if (threadScoreCaches[i].generation == generation) {
+            if (i > 0) {
+                std::swap(threadScoreCaches[0], threadScoreCaches[i]);
+            }
+            return threadScoreCaches[0].cache.get();
+        }
+    }
+
+    threadScoreCaches.erase(std::remove_if(threadScoreCaches.begin(), threadScoreCaches.end(), [](const ThreadScoreCache& c) {
+        return c.cache.use_count() == 1;
+    }), threadScoreCaches.end());
+
+    ThreadScoreCache threadScoreCache;
+    threadScoreCache.generation = generation;
+    threadScoreCache.cache = std::make_shared<chessScoreCache>(scoreCacheSize.load());
+    {
+        std::lock_guard<std::mutex> thelock(scoreCacheMutex);
+        scoreCaches.push_back(threadScoreCache.cache);
+    }
+    threadScoreCaches.insert(threadScoreCaches.begin(), threadScoreCache);
+    return threadScoreCaches[0].cache.get();
+}
+
+chessScoreCacheStats chessDb::getScoreCacheStats() const {
+    chessScoreCacheStats stats;
+    memset(&stats, 0, sizeof(stats));
+
+    std::lock_guard<std::mutex> thelock(scoreCacheMutex);
+    for (auto && cache : scoreCaches) {
+        stats.hits += cache->hits.load(std::memory_order_relaxed);
+        stats.misses += cache->misses.load(std::memory_order_relaxed);
+        stats.entryCnt = cache->getEntryCnt();
+    }
+    stats.cacheCnt = (i64)scoreCaches.size();
+    return stats;
+}
+
+void chessDb::resetScoreCacheStats() {
+    std::lock_guard<std::mutex> thelock(scoreCacheMutex);
+    for (auto && cache : scoreCaches) {
+        cache->hits = cache->misses = 0;
+    }
 }
 
 void chessDb::setFolders(const std::vector<std::string>& folders_) {
@@ -46,29 +152,270 @@ void chessDb::preload(const std::string& folder, chessMemMode chessMemMode, ches
 
 void chessDb::preload(chessMemMode chessMemMode, chessLoadMode loadMode) {
     for (auto && folderName : folders) {
-        auto vec = listdir(folderName);
-
-        for (auto && path : vec) {
-            if (chessFile::knownExtension(path)) {
-                chessFile *chessFile = new chessFile();
-                if (chessFile->preload(path, chessMemMode, loadMode)) {
-                    auto pos = nameMap.find(chessFile->getName());
-                    if (pos == nameMap.end()) {
-                        addchessFile(chessFile);
-                        continue;
+        preloadFolder(folderName, chessMemMode, loadMode);
+    }
+}
+
+void chessDb::preloadFolder(const std::string& folder, chessMemMode chessMemMode, chessLoadMode loadMode, const std::set<std::string>* skipNames) {
+    if (useCatalog && preloadCatalog(folder, chessMemMode, loadMode, skipNames)) {
+        return;
+    }
+
+    auto vec = listdir(folder);
+
+    for (auto && path : vec) {
+        if (chessFile::knownExtension(path) && (skipNames == nullptr || skipNames->count(chessFile::pathToName(path)) == 0)) {
+            preloadFile(path, chessMemMode, loadMode);
+        }
+    }
+}
+
+void chessDb::preloadFile(const std::string& path, chessMemMode chessMemMode, chessLoadMode loadMode) {
+    auto pchessFile = new chessFile();
+    auto fileMemMode = chessMemMode == chessMemMode::smart ? pickMemMode(path) : chessMemMode;
+    addOrMerge(pchessFile, pchessFile->preload(path, fileMemMode, loadMode), path);
+}
+
+bool chessDb::preloadCatalog(const std::string& folder, chessMemMode chessMemMode, chessLoadMode loadMode, const std::set<std::string>* skipNames) {
+    chessCatalog catalog;
+    if (!catalog.open(folder)) {
+        return false;
+    }
+
+    for (int i = 0; i < catalog.getEntryCnt(); i++) {
+        auto& entry = catalog.getEntry(i);
+        auto path = catalog.getPath(entry);
+        if (skipNames && skipNames->count(chessFile::pathToName(path))) {
+            continue;
+        }
+
+        // Changed since the catalog was written
+        if (!catalog.isUpToDate(entry)) {
+            preloadFile(path, chessMemMode, loadMode);
+            continue;
+        }
+
+        auto pchessFile = new chessFile();
+        auto fileMemMode = chessMemMode == chessMemMode::smart ? pickMemMode(path, entry.fileSize) : chessMemMode;
+        bool r = fileMemMode == chessMemMode::tiny && loadMode == chessLoadMode::loadnow
+                 ? pchessFile->preload(path, entry.header, catalog.getBlockTable(entry), entry.blockCnt)
+                 : pchessFile->preload(path, fileMemMode, loadMode);
+        addOrMerge(pchessFile, r, path);
+    }
+    return true;
+}
+
+void chessDb::addOrMerge(chessFile* pchessFile, bool loaded, const std::string& path) {
+    if (loaded) {
+        auto pos = nameMap.find(pchessFile->getName());
+        if (pos == nameMap.end()) {
+            addchessFile(pchessFile);
+            return;
+        }
+        if (!pos->second->merge(*pchessFile)) {
+            std::cout << "Error: not merged, " << pos->first << " is loaded already: " << path << std::endl;
+        }
+    } else {
+        std::cout << "Error: not loaded: " << path << std::endl;
+    }
+    delete pchessFile;
+}
+
+// Files are picked in order of folders, the first ones take the most memory
+chessMemMode chessDb::pickMemMode(const std::string& path, i64 fileSize) {
+    auto dataSize = chessFile::computeSize(chessFile::pathToName(path));
+
+    if (fileSize < 0) {
+        fileSize = 0;
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (file) {
+            fileSize = file.tellg();
+        }
+    }
+
+    auto remain = memoryBudget - memoryUsed;
+    if (dataSize > 0 && dataSize <= remain) {
+        memoryUsed += dataSize;
+        return chessMemMode::all;
+    }
+    if (fileSize > 0 && fileSize <= remain) {
+        memoryUsed += fileSize;
+        return chessMemMode::compressed;
+    }
+    return chessMemMode::tiny;
+}
+
+void chessDb::preloadParallel(const std::string& folder, chessMemMode chessMemMode, int threadCnt) {
+    addFolders(folder);
+    preloadParallel(std::vector<std::string> { folder }, chessMemMode, threadCnt);
+}
+
+void chessDb::preloadParallel(chessMemMode chessMemMode, int threadCnt) {
+    preloadParallel(folders, chessMemMode, threadCnt);
+}
+
+void chessDb::preloadParallel(const std::vector<std::string>& folderVec, chessMemMode chessMemMode, int threadCnt) {
+    auto startIdx = chessFileVec.size();
+
+    // Files of registered endgames may be loading on the pool, they are neither read again nor merged
+    std::set<std::string> skipNames;
+    for (auto && it : nameMap) {
+        skipNames.insert(it.first);
+    }
+
+    // Quick, it reads no data but creates files with their paths
+    for (auto && folderName : folderVec) {
+        preloadFolder(folderName, chessMemMode, chessLoadMode::onrequest, &skipNames);
+    }
+
+    if (preloadPool == nullptr || (threadCnt > 0 && threadCnt != preloadPool->getThreadCnt())) {
+        waitForPreload();
+        preloadPool.reset(new chessThreadPool(threadCnt));
+    }
+
+    for(auto i = startIdx; i < chessFileVec.size(); i++) {
+        auto pchessFile = chessFileVec[i];
+        pendingLoadCnt++;
+
+        preloadPool->submit([this, pchessFile]() {
+            pchessFile->checkToLoadHeaderAndTable();
+
+            if (chessVerbose) {
+                std::cout << (pchessFile->loadStatus == chessLoadStatus::loaded ? "Loaded " : "Error: not loaded ")
+                          << pchessFile->getName() << ", " << pchessFile->getLoadTime() << " s" << std::endl;
+            }
+            pendingLoadCnt--;
+        });
+    }
+}
+
+void chessDb::waitForPreload() {
+    if (preloadPool) {
+        preloadPool->wait();
+    }
+}
+
+void chessDb::deriveMissingSides(int threadCnt, bool persist) {
+    if (derivePool == nullptr || (threadCnt > 0 && threadCnt != derivePool->getThreadCnt())) {
+        waitForDerive();
+        derivePool.reset(new chessThreadPool(threadCnt));
+    }
+
+    for(auto && pchessFile : chessFileVec) {
+        pendingDeriveCnt++;
+        derivePool->submit([this, pchessFile, persist]() {
+            deriveSide(pchessFile, persist);
+        });
+    }
+}
+
+void chessDb::waitForDerive() {
+    if (derivePool) {
+        derivePool->wait();
+    }
+}
+
+void chessDb::deriveSide(chessFile* pchessFile, bool persist) {
+    pchessFile->checkToLoadHeaderAndTable();
+
+    auto header = pchessFile->header;
+    if (pchessFile->loadStatus == chessLoadStatus::error || header == nullptr
+        || header->isSide(Side::white) == header->isSide(Side::black)
+        || (header->property & chess_PROP_SPECIAL_SCORE_RANGE)) {
+        pendingDeriveCnt--;
+        return;
+    }
+
+    // Derived by an earlier call
+    auto side = header->isSide(Side::white) ? Side::black : Side::white;
+    if (pchessFile->hasSide(side)) {
+        pendingDeriveCnt--;
+        return;
+    }
+
+    auto size = pchessFile->getSize();
+    auto data = (char*)malloc(size);
+    if (data == nullptr) {
+        std::cerr << "Error: cannot allocate memory to derive " << pchessFile->getName() << std::endl;
+        pendingDeriveCnt--;
+        return;
+    }
+
+    // Chunks are searched by other tasks, the last one to finish installs the side
+    const i64 chunkSize = 64 * 1024;
+    auto chunkCnt = (int)((size + chunkSize - 1) / chunkSize);
+    auto remainCnt = std::make_shared<std::atomic<int>>(chunkCnt);
+    auto failed = std::make_shared<std::atomic<bool>>(false);
+    auto startTime = std::chrono::steady_clock::now();
+
+    for(int k = 0; k < chunkCnt; k++) {
+        derivePool->submit([this, pchessFile, persist, side, size, data, k, remainCnt, failed, startTime]() {
+            chessProbeBoard board;
+            auto xside = getXSide(side);
+            auto toIdx = MIN(size, (i64)(k + 1) * chunkSize);
+
+            for(auto idx = (i64)k * chunkSize; idx < toIdx && !*failed; idx++) {
+                if (!pchessFile->setupBoard(board, idx, FlipMode::none, Side::white) || board.isIncheck(xside)) {
+                    data[idx] = TB_ILLEGAL;
+                    continue;
+                }
+                board.side = side;
+                data[idx] = chessFile::scoreToCell(getScoreOnePly(board, side));
+                if (data[idx] == TB_UNSET) {
+                    failed->store(true);
+                }
+            }
+
+            if (--*remainCnt > 0) {
+                return;
+            }
+
+            if (*failed) {
+                if (chessVerbose) {
+                    std::cerr << "Error: cannot derive " << pchessFile->getName() << ", scores out of range" << std::endl;
+                }
+                free(data);
+            } else {
+                if (persist) {
+                    auto path = pchessFile->getPath(static_cast<int>(xside));
+                    auto p = path.find_last_of("/\\");
+                    auto folder = p == std::string::npos ? std::string(".") : path.substr(0, p);
+                    path = folder + "/" + pchessFile->getName() + (side == Side::white ? "w" : "b") + ".zmt";
+
+                    if (std::ifstream(path).good()) {
+                        if (chessVerbose) {
+                            std::cout << "Not saved " << path << ", file exists" << std::endl;
+                        }
+                    } else {
+                        chessFile::saveSideFile(path, *pchessFile->header, side, data, size);
                     }
-                    pos->second->merge(*chessFile);
-                } else {
-                    std::cout << "Error: not loaded: " << path << std::endl;
                 }
-                free(chessFile);
+
+                // Scores of the side were one-ply searches before, thus score caches are still right
+                pchessFile->setSideData(side, data);
+
+                if (chessVerbose) {
+                    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+                    std::cout << "Derived " << pchessFile->getName() << (side == Side::white ? " white" : " black")
+                              << ", " << elapsed << " s" << std::endl;
+                }
             }
-        }
+            pendingDeriveCnt--;
+        });
     }
 }
 
 void chessDb::addchessFile(chessFile *chessFile) {
     chessFileVec.push_back(chessFile);
+    chessFile->blockCache = &blockCache;
+
+    // Letters of the name are the pieces
+    if (chessFile->getName().size() >= chess_PARALLEL_DECOMPRESS_PIECES) {
+        if (decompressPool == nullptr) {
+            decompressPool.reset(new chessThreadPool());
+        }
+        chessFile->decompressPool = decompressPool.get();
+    }
 
     auto s = chessFile->getName();
     nameMap[s] = chessFile;
@@ -77,13 +424,17 @@ void chessDb::addchessFile(chessFile *chessFile) {
     auto s1 = s.substr(p);
     s = s1 + s0;
     nameMap[s] = chessFile;
+
+    auto materialKey = chessFile::nameToMaterialKey(chessFile->getName());
+    materialTable.add(materialKey, chessFile);
+    materialTable.add(chessBoardCore::flipMaterialKey(materialKey), chessFile);
 }
 
 ////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////
 
 int chessDb::getScore(const std::vector<Piece> pieceVec, Side side) {
-    chessBoard board;
+    chessProbeBoard board;
     board.setup(pieceVec, side);
     return getScore(board, board.side);
 }
@@ -93,27 +444,163 @@ int chessDb::getScore(chessBoardCore& board) {
 }
 
 int chessDb::getScore(chessBoardCore& board, Side side) {
+    return getScore<chessBoardCore>(board, side);
+}
+
+template <class Board>
+int chessDb::getScore(Board& board, Side side) {
     assert(side == Side::white || side == Side::black);
+    chess_STATS_ADD(probes, 1);
+
+    if (scoreCacheSize.load(std::memory_order_relaxed) <= 0) {
+        return getScoreNoCache(board, side);
+    }
+
+    auto scoreCache = getThreadScoreCache();
+    auto key = zobrist.positionKey(board.hashKey, side, board.enpassant);
+    int score;
+    if (scoreCache->get(key, score)) {
+        return score;
+    }
+
+    score = getScoreNoCache(board, side);
+    if (score != chess_SCORE_MISSING) {
+        scoreCache->put(key, score);
+    }
+    return score;
+}
 
-    chessFile* pchessFile = getchessFile(board);
+template <class Board>
+int chessDb::getScoreNoCache(Board& board, Side side) {
+    assert(board.hashKey == chessBoardCore::pieceList_hashKey((const Piece*)board.pieceList));
+
+    chessFile* pchessFile = materialTable.find(board.materialKey);
     if (pchessFile == nullptr || pchessFile->loadStatus == chessLoadStatus::error) {
         return chess_SCORE_MISSING;
     }
 
     pchessFile->checkToLoadHeaderAndTable();
-    auto r = pchessFile->getKey(board);
+    auto r = pchessFile->getPieceListKey(board.pieceList);
     auto querySide = r.flipSide ? getXSide(side) : side;
 
-    if (pchessFile->header->isSide(querySide) && board.enpassant <= 0) {
+    if (pchessFile->hasSide(querySide) && board.enpassant <= 0) {
         int score = pchessFile->getScore(r.key, querySide);
         return score;
     }
 
+    chess_STATS_ADD(onePlyEnpassant, board.enpassant > 0);
+    chess_STATS_ADD(onePlyMissingSide, board.enpassant <= 0);
     return getScoreOnePly(board, side);
 }
 
+std::vector<int> chessDb::getScoreBatch(const std::vector<chessBoardCore*>& boards) {
+    std::vector<int> scores(boards.size());
+    getScoreBatch(boards.data(), (int)boards.size(), scores.data());
+    return scores;
+}
+
+void chessDb::getScoreBatch(chessBoardCore* const* boards, int cnt, int* scores) {
+    class ProbeItem {
+    public:
+        chessFile* pchessFile;
+        i64 key;
+        int sd, order;
+    };
+
+    std::vector<ProbeItem> items;
+    items.reserve(cnt);
+    chess_STATS_ADD(probes, cnt);
+
+    // The same score cache as getScore, boards found in it are not probed
+    auto scoreCache = scoreCacheSize.load(std::memory_order_relaxed) > 0 ? getThreadScoreCache() : nullptr;
+
+    for(int i = 0; i < cnt; i++) {
+        auto& board = *boards[i];
+        assert(board.side == Side::white || board.side == Side::black);
+
+        if (scoreCache && scoreCache->get(zobrist.positionKey(board.hashKey, board.side, board.enpassant), scores[i])) {
+            continue;
+        }
+
+        chessFile* pchessFile = getchessFile(board);
+        if (pchessFile == nullptr || pchessFile->loadStatus == chessLoadStatus::error) {
+            scores[i] = chess_SCORE_MISSING;
+            continue;
+        }
+
+        pchessFile->checkToLoadHeaderAndTable();
+        items.push_back({ pchessFile, 0, 0, i });
+    }
+
+    // Keys of boards of the same file are computed together
+    std::stable_sort(items.begin(), items.end(), [](const ProbeItem& a, const ProbeItem& b) {
+        return a.pchessFile->fileId < b.pchessFile->fileId;
+    });
+
+    std::vector<const chessBoardCore*> fileBoards;
+    std::vector<chessKeyRec> recs;
+    size_t probeCnt = 0;
+    for(size_t begin = 0, end; begin < items.size(); begin = end) {
+        auto pchessFile = items[begin].pchessFile;
+        fileBoards.clear();
+        for(end = begin; end < items.size() && items[end].pchessFile == pchessFile; end++) {
+            fileBoards.push_back(boards[items[end].order]);
+        }
+
+        recs.resize(fileBoards.size());
+        pchessFile->getKeys(fileBoards.data(), (int)fileBoards.size(), recs.data());
+
+        for(auto k = begin; k < end; k++) {
+            auto order = items[k].order;
+            auto& board = *boards[order];
+            auto& r = recs[k - begin];
+            auto querySide = r.flipSide ? getXSide(board.side) : board.side;
+
+            if (pchessFile->hasSide(querySide) && board.enpassant <= 0) {
+                items[probeCnt++] = { pchessFile, r.key, static_cast<int>(querySide), order };
+            } else {
+                chess_STATS_ADD(onePlyEnpassant, board.enpassant > 0);
+                chess_STATS_ADD(onePlyMissingSide, board.enpassant <= 0);
+                scores[order] = getScoreOnePly(board, board.side);
+                if (scoreCache && scores[order] != chess_SCORE_MISSING) {
+                    scoreCache->put(zobrist.positionKey(board.hashKey, board.side, board.enpassant), scores[order]);
+                }
+            }
+        }
+    }
+    items.resize(probeCnt);
+
+    std::sort(items.begin(), items.end(), [](const ProbeItem& a, const ProbeItem& b) {
+        if (a.pchessFile != b.pchessFile) {
+            return a.pchessFile->fileId < b.pchessFile->fileId;
+        }
+        if (a.sd != b.sd) {
+            return a.sd < b.sd;
+        }
+        return a.key < b.key;
+    });
+
+    // Keys of a block are next to each other now, the block is kept by the thread after reading
+    for(auto && item : items) {
+        scores[item.order] = item.pchessFile->getScore(item.key, static_cast<Side>(item.sd));
+    }
+
+    if (scoreCache) {
+        for(auto && item : items) {
+            auto& board = *boards[item.order];
+            if (scores[item.order] != chess_SCORE_MISSING) {
+                scoreCache->put(zobrist.positionKey(board.hashKey, board.side, board.enpassant), scores[item.order]);
+            }
+        }
+    }
+}
+
 int chessDb::getScoreOnePly(chessBoardCore& board, Side side) {
+    return getScoreOnePly<chessBoardCore>(board, side);
+}
 
+template <class Board>
+int chessDb::getScoreOnePly(Board& board, Side side) {
     auto xside = getXSide(side);
 
     MoveList moveList;
@@ -151,23 +638,28 @@ int chessDb::getScoreOnePly(chessBoardCore& board, Side side) {
 }
 
 chessFile* chessDb::getchessFile(const chessBoardCore& board) const {
-    auto name = chessFile::pieceListToName((const Piece* )board.pieceList);
-    return nameMap.find(name) != nameMap.end() ? nameMap.at(name) : nullptr;
+    assert(board.materialKey == chessBoardCore::pieceList_materialKey((const Piece*)board.pieceList));
+    return materialTable.find(board.materialKey);
 }
 
 int chessDb::probe(const std::vector<Piece> pieceVec, Side side, MoveList& moveList) {
-    chessBoard board;
+    chessProbeBoard board;
     board.setup(pieceVec, side);
     return probe(board, moveList);
 }
 
 int chessDb::probe(const char* fenString, MoveList& moveList) {
-    chessBoard board;
+    chessProbeBoard board;
     board.setFen(fenString);
     return probe(board, moveList);
 }
 
 int chessDb::probe(chessBoardCore& board, MoveList& moveList) {
+    return probe<chessBoardCore>(board, moveList);
+}
+
+template <class Board>
+int chessDb::probe(Board& board, MoveList& moveList) {
     auto side = board.side;
     auto xside = getXSide(board.side);
     int bestScore = -chess_SCORE_MATE, legalMoveCnt = 0;
@@ -242,3 +734,13 @@ int chessDb::probe(chessBoardCore& board, MoveList& moveList) {
     return bestScore;
 }
 
+template int chessDb::getScore<chessBoardCore>(chessBoardCore& board, Side side);
+template int chessDb::getScore<chessBoard>(chessBoard& board, Side side);
+template int chessDb::getScore<chessBitBoard>(chessBitBoard& board, Side side);
+
+template int chessDb::probe<chessBoardCore>(chessBoardCore& board, MoveList& moveList);
+template int chessDb::probe<chessBoard>(chessBoard& board, MoveList& moveList);
+template int chessDb::probe<chessBitBoard>(chessBitBoard& board, MoveList& moveList);
+
+template int chessDb::getScoreOnePly<chessBoard>(chessBoard& board, Side side);
+template int chessDb::getScoreOnePly<chessBitBoard>(chessBitBoard& board, Side side);
@@ -1,20 +1,127 @@
 #ifndef chessDb_h
 #define chessDb_h
 
+#include <atomic>
+#include <memory>
+#include <mutex>
 #include <vector>
 #include <map>
+#include <set>
 #include <string>
 
 #include "chess.h"
 #include "chessFile.h"
 #include "chessBoard.h"
+#include "chesspool.h"
 
 namespace chess {
 
+    /*
+     * Files by material keys, open addressing with linear probing.
+     * Material keys are never zero (kings), zero marks empty slots
+     */
+    class chessMaterialTable {
+    public:
+        void clear() {
+            slots.clear();
+            cnt = 0;
+        }
+
+        void add(u64 key, chessFile* pchessFile) {
+            assert(key != 0);
+            if ((cnt + 1) * 2 > (int)slots.size()) {
+                grow();
+            }
+            auto& slot = findSlot(key);
+            if (slot.key == 0) {
+                cnt++;
+            }
+            slot.key = key;
+            slot.pchessFile = pchessFile;
+        }
+
+        chessFile* find(u64 key) const {
+            if (slots.empty()) {
+                return nullptr;
+            }
+            for(auto i = hash(key); ; i = (i + 1) & mask) {
+                auto& slot = slots[i];
+                if (slot.key == key) {
+                    return slot.pchessFile;
+                }
+                if (slot.key == 0) {
+                    return nullptr;
+                }
+            }
+        }
+
+    private:
+        class Slot {
+        public:
+            u64 key = 0;
+            chessFile* pchessFile = nullptr;
+        };
+
+        std::vector<Slot> slots;
+        size_t mask = 0;
+        int cnt = 0, shift = 64;
+
+        size_t hash(u64 key) const {
+            return (size_t)((key * 0x9E3779B97F4A7C15ULL) >> shift);
+        }
+
+        Slot& findSlot(u64 key) {
+            auto i = hash(key);
+            while (slots[i].key != 0 && slots[i].key != key) {
+                i = (i + 1) & mask;
+            }
+            return slots[i];
+        }
+
+        void grow() {
+            auto oldSlots = std::move(slots);
+            size_t sz = oldSlots.empty() ? 64 : oldSlots.size() * 2;
+            slots.assign(sz, Slot());
+            mask = sz - 1;
+            for(shift = 64; sz > 1; sz >>= 1) {
+                shift--;
+            }
+            for(auto && slot : oldSlots) {
+                if (slot.key) {
+                    findSlot(slot.key) = slot;
+                }
+            }
+        }
+    };
+
     class chessDb {
     protected:
         std::vector<std::string> folders;
         std::map<std::string, chessFile*> nameMap;
+        chessMaterialTable materialTable;
+
+        chessBlockCache blockCache;
+
+        std::unique_ptr<chessThreadPool> preloadPool;
+        std::atomic<int> pendingLoadCnt;
+
+        std::unique_ptr<chessThreadPool> derivePool;
+        std::atomic<int> pendingDeriveCnt;
+
+        // Shared by files loading big sides, apart from preloadPool since loading tasks wait for it.
+        // Created with the first endgame of chess_PARALLEL_DECOMPRESS_PIECES pieces
+        std::unique_ptr<chessThreadPool> decompressPool;
+
+        // memMode smart: memory given to all files and memory taken by loaded ones
+        i64 memoryBudget, memoryUsed;
+
+        bool useCatalog;
+
+        // Score caches of threads, a thread gets a new one when the generation changes
+        std::atomic<int> scoreCacheSize;
+        std::atomic<u64> scoreCacheGeneration;
+        mutable std::mutex scoreCacheMutex;
+        std::vector<std::shared_ptr<chessScoreCache>> scoreCaches;
 
     public:
         std::vector<chessFile*> chessFileVec;
@@ -26,6 +133,27 @@ namespace chess {
         // Call it to release memory
         void removeAllBuffers();
 
+        // Decompressed blocks shared by all files (memory modes tiny, mapped), 0 to disable
+        void setBlockCacheSize(i64 byteBudget);
+        chessBlockCacheStats getBlockCacheStats() const;
+        void resetBlockCacheStats();
+
+        // Scores of each probing thread kept by Zobrist keys, entries per thread, 0 to disable.
+        // A thread keeps a cache for each chessDb it probes, dropped with the chessDb or by the next setScoreCacheSize
+        void setScoreCacheSize(int entryCnt);
+        int getScoreCacheSize() const { return scoreCacheSize; }
+        chessScoreCacheStats getScoreCacheStats() const;
+        void resetScoreCacheStats();
+
+        // Counters of all chessDb of the process since it started (all zero if built with chess_STATS 0),
+        // the difference of two snapshots gives the counts of an interval
+        chessStats stats() const { return chessThreadCounters::getStats(); }
+
+        // memMode smart: each file is loaded as all if its data fits into the rest of the budget,
+        // compressed if its compressed data fits, otherwise tiny
+        void setMemoryBudget(i64 byteBudget) { memoryBudget = byteBudget; }
+        i64 getMemoryBudget() const { return memoryBudget; }
+
         int getSize() const {
             return (int)chessFileVec.size();
         }
@@ -34,16 +162,57 @@ namespace chess {
         void setFolders(const std::vector<std::string>& folders);
         void addFolders(const std::string& folderName);
 
+        // A folder having an up-to-date catalog (chessCatalog::create) is set up from it without listing
+        // folders, with memMode tiny headers and block tables are taken from it too
         void preload(chessMemMode chessMemMode = chessMemMode::tiny, chessLoadMode loadMode = chessLoadMode::onrequest);
         void preload(const std::string& folder, chessMemMode chessMemMode, chessLoadMode loadMode = chessLoadMode::onrequest);
 
+        void setUseCatalog(bool use) { useCatalog = use; }
+        bool isUseCatalog() const { return useCatalog; }
+
+        // Register all files then load them on threadCnt threads (0: number of cores), one file per task.
+        // Endgames registered by earlier calls are kept as they are, only files of new ones are read.
+        // It returns at once, files could be probed while others are loading (probing a file being loaded
+        // waits for that file only). chessFile::isReady / getLoadTime tell the status of each file
+        void preloadParallel(chessMemMode chessMemMode = chessMemMode::all, int threadCnt = 0);
+        void preloadParallel(const std::string& folder, chessMemMode chessMemMode, int threadCnt = 0);
+
+        bool isPreloadDone() const { return pendingLoadCnt == 0; }
+        void waitForPreload();
+
+        // Files having one side only get the other side computed by one-ply searches over the whole index range,
+        // on threadCnt threads (0: number of cores). It returns at once, probes use one-ply searches for
+        // a side until it is ready, then read it from memory. persist: the side is saved next to the file
+        // (name + w/b + .zmt, never overwritten) thus later runs load it as usual
+        void deriveMissingSides(int threadCnt = 0, bool persist = false);
+        bool isDeriveDone() const { return pendingDeriveCnt == 0; }
+        void waitForDerive();
+
         // Scores
         int getScore(chessBoardCore& board, Side side);
         int getScore(chessBoardCore& board);
         int getScore(const std::vector<Piece> pieceVec, Side side);
 
+        // Same as above for concrete boards (chessBoard, chessBitBoard), board functions are called without virtual calls
+        template <class Board> int getScore(Board& board, Side side);
+        template <class Board> int getScore(Board& board) {
+            return getScore(board, board.side);
+        }
+
+        // Score from the scores of the children (one-ply search), used for sides which are not in files
+        // and en passant positions
+        int getScoreOnePly(chessBoardCore& board, Side side);
+        template <class Board> int getScoreOnePly(Board& board, Side side);
+
+        // Scores of many boards at once, scores are in the same order of boards
+        // Probes are sorted by (file, side, block) thus each needed block is read once only.
+        // Boards go through the score cache of the thread as getScore does
+        void getScoreBatch(chessBoardCore* const* boards, int cnt, int* scores);
+        std::vector<int> getScoreBatch(const std::vector<chessBoardCore*>& boards);
+
         // Probe (for getting the line of moves to win
         int probe(chessBoardCore& board, MoveList& moveList);
+        template <class Board> int probe(Board& board, MoveList& moveList);
         int probe(const std::vector<Piece> pieceVec, Side side, MoveList& moveList);
         int probe(const char* fenString, MoveList& moveList);
 
@@ -56,7 +225,21 @@ namespace chess {
     private:
         void addchessFile(chessFile *chessFile);
 
-        int getScoreOnePly(chessBoardCore& board, Side side);
+        // skipNames: endgames registered before, their files are not read again
+        void preloadFolder(const std::string& folder, chessMemMode chessMemMode, chessLoadMode loadMode, const std::set<std::string>* skipNames = nullptr);
+        void preloadFile(const std::string& path, chessMemMode chessMemMode, chessLoadMode loadMode);
+        bool preloadCatalog(const std::string& folder, chessMemMode chessMemMode, chessLoadMode loadMode, const std::set<std::string>* skipNames);
+        void preloadParallel(const std::vector<std::string>& folderVec, chessMemMode chessMemMode, int threadCnt);
+        void addOrMerge(chessFile* pchessFile, bool loaded, const std::string& path);
+
+        chessMemMode pickMemMode(const std::string& path, i64 fileSize = -1);
+
+        void deriveSide(chessFile* pchessFile, bool persist);
+
+
+        template <class Board> int getScoreNoCache(Board& board, Side side);
+        chessScoreCache* getThreadScoreCache();
+        void newScoreCacheGeneration();
 
     };
 
@@ -1,3 +1,4 @@
+#include <chrono>
 #include <fstream>
 #include <iomanip>
 #include <ctime>
@@ -13,22 +14,6 @@ extern int *kk_2, *kk_8;
 
 //////////////////////////////////////////////////////////////////////
 
-#define TB_ILLEGAL              0
-#define TB_UNSET                1
-#define TB_MISSING              2
-#define TB_WINING               3
-#define TB_UNKNOWN              4
-#define TB_DRAW                 5
-
-#define TB_START_MATING         (TB_DRAW + 1)
-#define TB_START_LOSING         130
-
-#define TB_SPECIAL_DRAW         0
-#define TB_SPECIAL_START_MATING (TB_SPECIAL_DRAW + 1)
-#define TB_SPECIAL_START_LOSING 128
-
-//////////////////////////////////////////////////////////////////////
-
 const char* chessFileExtensions[] = {
     ".mtb", ".zmt", nullptr
 };
@@ -46,12 +31,23 @@ bool chessFile::knownExtension(const std::string& path) {
 //////////////////////////////////////////////////////////////////////
 // Construction/Destruction
 //////////////////////////////////////////////////////////////////////
+static std::atomic<u32> fileIdCnt { 0 };
+
 chessFile::chessFile() {
-    pBuf[0] = pBuf[1] = pCompressBuf = nullptr;
+    fileId = ++fileIdCnt;
+    pBuf[0] = pBuf[1] = nullptr;
+    resident[0] = resident[1] = false;
     compressBlockTables[0] = compressBlockTables[1] = nullptr;
+    pMap[0] = pMap[1] = nullptr;
+    mapSize[0] = mapSize[1] = 0;
+    pCompressData[0] = pCompressData[1] = nullptr;
     header = nullptr;
+    blockCache = nullptr;
+    decompressPool = nullptr;
+    keyEncoder = nullptr;
     memMode = chessMemMode::tiny;
     loadStatus = chessLoadStatus::none;
+    loadTime = 0;
     reset();
 }
 
@@ -73,28 +69,52 @@ void chessFile::reset() {
 };
 
 void chessFile::removeBuffers() {
-    if (pCompressBuf) free(pCompressBuf);
-    pCompressBuf = nullptr;
-
     for (int i = 0; i < 2; i++) {
+        resident[i] = false;
+
         if (pBuf[i]) {
-            free(pBuf[i]);
+            if (!isMapped(pBuf[i], i)) {
+                free(pBuf[i]);
+            }
             pBuf[i] = nullptr;
         }
 
         if (compressBlockTables[i]) {
-            free(compressBlockTables[i]);
+            if (!isMapped(compressBlockTables[i], i)) {
+                free(compressBlockTables[i]);
+            }
             compressBlockTables[i] = nullptr;
         }
 
+        if (pCompressData[i]) {
+            if (!isMapped(pCompressData[i], i)) {
+                free(pCompressData[i]);
+            }
+            pCompressData[i] = nullptr;
+        }
+
+        unmap(i);
         startpos[i] = endpos[i] = 0;
     }
     loadStatus = chessLoadStatus::none;
 }
 
+void chessFile::unmap(int sd) {
+    if (pMap[sd]) {
+        unmapFile(pMap[sd], mapSize[sd]);
+        pMap[sd] = nullptr;
+    }
+    mapSize[sd] = 0;
+}
+
 //////////////////////////////////////////////////////////////////////
-void chessFile::merge(chessFile& otherchessFile)
+bool chessFile::merge(chessFile& otherchessFile)
 {
+    // A loaded file takes sides of loaded files only
+    if (header != nullptr && otherchessFile.header == nullptr) {
+        return false;
+    }
+
     for(int sd = 0; sd < 2; sd++) {
         Side side = static_cast<Side>(sd);
         if (header == nullptr) {
@@ -109,23 +129,42 @@ void chessFile::merge(chessFile& otherchessFile)
             header->addSide(side);
             setPath(otherchessFile.getPath(sd), sd);
 
-            if (compressBlockTables[sd]) {
+            if (compressBlockTables[sd] && !isMapped(compressBlockTables[sd], sd)) {
                 free(compressBlockTables[sd]);
             }
             compressBlockTables[sd] = otherchessFile.compressBlockTables[sd];
+            otherchessFile.compressBlockTables[sd] = nullptr;
+
+            if (otherchessFile.pCompressData[sd]) {
+                if (pCompressData[sd] && !isMapped(pCompressData[sd], sd)) {
+                    free(pCompressData[sd]);
+                }
+                pCompressData[sd] = otherchessFile.pCompressData[sd];
+                otherchessFile.pCompressData[sd] = nullptr;
+            }
+
+            if (otherchessFile.pMap[sd]) {
+                unmap(sd);
+                pMap[sd] = otherchessFile.pMap[sd];
+                mapSize[sd] = otherchessFile.mapSize[sd];
+                otherchessFile.pMap[sd] = nullptr;
+                otherchessFile.mapSize[sd] = 0;
+            }
 
             if (pBuf[sd] == nullptr && otherchessFile.pBuf[sd] != nullptr) {
                 pBuf[sd] = otherchessFile.pBuf[sd];
                 startpos[sd] = otherchessFile.startpos[sd];
                 endpos[sd] = otherchessFile.endpos[sd];
+                resident[sd] = otherchessFile.resident[sd].load();
 
                 otherchessFile.pBuf[sd] = nullptr;
+                otherchessFile.resident[sd] = false;
                 otherchessFile.startpos[sd] = 0;
                 otherchessFile.endpos[sd] = 0;
-                otherchessFile.compressBlockTables[sd] = nullptr;
             }
         }
     }
+    return true;
 }
 
 void chessFile::setPath(const std::string& s, int sd) {
@@ -147,9 +186,93 @@ bool chessFile::createBuf(i64 len, int sd) {
 //////////////////////////////////////////////////////////////////////
 // Preload files
 //////////////////////////////////////////////////////////////////////
+std::string chessFile::pathToName(const std::string& path) {
+    auto theName = getFileName(path);
+    toLower(theName);
+    return theName.substr(0, theName.empty() ? 0 : theName.length() - 1); // remove W / B
+}
+
+char chessFile::scoreToCell(int score) {
+    switch (score) {
+        case chess_SCORE_DRAW:
+            return TB_DRAW;
+        case chess_SCORE_ILLEGAL:
+            return TB_ILLEGAL;
+        case chess_SCORE_MISSING:
+            return TB_MISSING;
+        case chess_SCORE_WINNING:
+            return TB_WINING;
+        case chess_SCORE_UNKNOWN:
+            return TB_UNKNOWN;
+    }
+
+    if (score > 0 && score < chess_SCORE_MATE) {
+        auto cell = TB_START_MATING + (chess_SCORE_MATE - score - 1) / 2;
+        return cell < TB_START_LOSING ? (char)cell : TB_UNSET;
+    }
+    if (score < 0 && score >= -chess_SCORE_MATE) {
+        auto cell = TB_START_LOSING + (score + chess_SCORE_MATE) / 2;
+        return cell <= 255 ? (char)cell : TB_UNSET;
+    }
+    return TB_UNSET;
+}
+
+bool chessFile::saveSideFile(const std::string& path, chessFileHeader header, Side side, const char* data, i64 size) {
+    int maxMoves = 0;
+    for(i64 i = 0; i < size; i++) {
+        auto cell = (u8)data[i];
+        if (cell >= TB_START_LOSING) {
+            maxMoves = MAX(maxMoves, cell - TB_START_LOSING);
+        } else if (cell >= TB_START_MATING) {
+            maxMoves = MAX(maxMoves, cell - TB_START_MATING + 1);
+        }
+    }
+
+    header.property = (1 << static_cast<int>(side)) | chess_PROP_COMPRESSED | chess_PROP_LZ4;
+    header.dtm_max = (u8)MIN(maxMoves, 255);
+
+    auto blockCnt = (int)((size + chess_SIZE_COMPRESS_BLOCK - 1) / chess_SIZE_COMPRESS_BLOCK);
+    std::vector<u32> blockTable(blockCnt);
+    std::vector<char> compData;
+    compData.reserve(size / 4);
+
+    char buf[chess_SIZE_COMPRESS_BLOCK];
+    u32 offset = 0;
+    for(int i = 0; i < blockCnt; i++) {
+        auto src = data + (i64)i * chess_SIZE_COMPRESS_BLOCK;
+        auto blockSize = (int)MIN(size - (i64)i * chess_SIZE_COMPRESS_BLOCK, (i64)chess_SIZE_COMPRESS_BLOCK);
+
+        // Blocks which could not be smaller are kept uncompressed
+        auto compSz = compressLz4(buf, blockSize - 1, src, blockSize);
+        if (compSz > 0) {
+            compData.insert(compData.end(), buf, buf + compSz);
+            offset += compSz;
+            blockTable[i] = offset;
+        } else {
+            compData.insert(compData.end(), src, src + blockSize);
+            offset += blockSize;
+            blockTable[i] = offset | chess_UNCOMPRESS_BIT;
+        }
+    }
+
+    std::ofstream outfile(path, std::ios::binary);
+    if (!outfile || !header.saveFile(outfile)) {
+        std::cerr << "Error: cannot write " << path << std::endl;
+        return false;
+    }
+    outfile.write((const char*)blockTable.data(), blockCnt * sizeof(u32));
+    outfile.write(compData.data(), compData.size());
+
+    if (chessVerbose) {
+        std::cout << "Saved " << path << ", " << offset << " bytes, longest mate " << maxMoves << " moves" << std::endl;
+    }
+    return (bool)outfile;
+}
+
 bool chessFile::preload(const std::string& path, chessMemMode _memMode, chessLoadMode _loadMode) {
+    // Size is not known yet, compute it from the name
     if (_memMode == chessMemMode::smart) {
-        _memMode = getSize() < chess_SMART_MODE_THRESHOLD ? chessMemMode::all : chessMemMode::tiny;
+        _memMode = computeSize(pathToName(path)) < chess_SMART_MODE_THRESHOLD ? chessMemMode::all : chessMemMode::compressed;
     }
 
     memMode = _memMode;
@@ -165,51 +288,95 @@ bool chessFile::preload(const std::string& path, chessMemMode _memMode, chessLoa
         int loadingSd = theName.find("w") != std::string::npos ? W : B;
         setPath(path, loadingSd);
 
-        theName = theName.substr(0, theName.length() - 1); // remove W / B
-        chessName = theName;
+        chessName = pathToName(path);
 
         setupIdxComputing(getName(), 0, 3);
         return true;
     }
 
+    auto startTime = std::chrono::steady_clock::now();
     bool r = loadHeaderAndTable(path);
+    loadTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
     loadStatus = r ? chessLoadStatus::loaded : chessLoadStatus::error;
     return r;
 }
 
-// Load all data too if requested
-bool chessFile::loadHeaderAndTable(const std::string& path) {
-    assert(path.size() > 8);
-    std::ifstream file(path, std::ios::binary);
+bool chessFile::preload(const std::string& path, const char* headerData, const u32* blockTable, i64 blockCnt) {
+    memMode = chessMemMode::tiny;
+    loadMode = chessLoadMode::loadnow;
+
+    auto oldSide = createHeader();
+    auto loadingSide = Side::none;
+
+    bool r = header->readFile(headerData, chess_HEADER_SIZE) && acceptHeader(path, oldSide, loadingSide);
+
+    if (r) {
+        auto sd = static_cast<int>(loadingSide);
+        startpos[sd] = endpos[sd] = 0;
 
-    // if there are files for both sides, header has been created already
-    auto oldSide = Side::none;
+        if (isCompressed()) {
+            r = blockCnt == getCompresseBlockCount();
+            if (r) {
+                compressBlockTables[sd] = (u32*) malloc(blockCnt * sizeof(u32) + 64);
+                memcpy(compressBlockTables[sd], blockTable, blockCnt * sizeof(u32));
+            }
+        }
+    }
+
+    loadTime = 0;
+    loadStatus = r ? chessLoadStatus::loaded : chessLoadStatus::error;
+    return r;
+}
+
+// if there are files for both sides, header has been created already
+Side chessFile::createHeader() {
     if (header == nullptr) {
         header = new chessFileHeader();
-    } else {
-        oldSide = header->isSide(Side::black) ? Side::black : Side::white;
+        return Side::none;
     }
-    auto loadingSide = Side::none;
+    return header->isSide(Side::black) ? Side::black : Side::white;
+}
 
-    bool r = false;
-    if (file && header->readFile(file) && header->isValid()) {
-        loadingSide = header->isSide(Side::white) ? Side::white : Side::black;
-        assert(loadingSide == (path.find("w.") != std::string::npos ? Side::white : Side::black));
-        chessName = header->name;
+// Header data has been read, check it and setup indexes
+bool chessFile::acceptHeader(const std::string& path, Side oldSide, Side& loadingSide) {
+    if (!header->isValid()) {
+        return false;
+    }
 
-        setPath(path, static_cast<int>(loadingSide));
-        header->setOnlySide(loadingSide);
-        assert(loadingSide == (path.find("w.") != std::string::npos ? Side::white : Side::black));
-        r = loadingSide != Side::none;
+    loadingSide = header->isSide(Side::white) ? Side::white : Side::black;
+    assert(loadingSide == (path.find("w.") != std::string::npos ? Side::white : Side::black));
+    chessName = header->name;
 
-        if (r) {
-            setupIdxComputing(getName(), header->order, header->getVersion());
+    setPath(path, static_cast<int>(loadingSide));
+    header->setOnlySide(loadingSide);
+    assert(loadingSide == (path.find("w.") != std::string::npos ? Side::white : Side::black));
+    if (loadingSide == Side::none) {
+        return false;
+    }
 
-            if (oldSide != Side::none) {
-                header->addSide(oldSide);
-            }
-        }
+    setupIdxComputing(getName(), header->order, header->getVersion());
+
+    if (oldSide != Side::none) {
+        header->addSide(oldSide);
     }
+    return true;
+}
+
+// Load all data too if requested
+bool chessFile::loadHeaderAndTable(const std::string& path) {
+    assert(path.size() > 8);
+    if (memMode == chessMemMode::mapped) {
+        return mapHeaderAndTable(path);
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    chess_STATS_ADD(fileOpens, 1);
+
+    auto oldSide = createHeader();
+    auto loadingSide = Side::none;
+
+    bool r = file && header->readFile(file) && acceptHeader(path, oldSide, loadingSide);
+    chess_STATS_ADD(bytesRead, r ? chess_HEADER_SIZE : 0);
 
     auto sd = static_cast<int>(loadingSide);
     startpos[sd] = endpos[sd] = 0;
@@ -230,10 +397,12 @@ bool chessFile::loadHeaderAndTable(const std::string& path) {
             compressBlockTables[sd] = nullptr;
             return false;
         }
-
+        chess_STATS_ADD(bytesRead, blockTableSz);
     }
 
-    if (r && memMode == chessMemMode::all) {
+    if (r && memMode == chessMemMode::compressed && isCompressed()) {
+        r = loadCompressedData(file, loadingSide);
+    } else if (r && (memMode == chessMemMode::all || memMode == chessMemMode::compressed)) {
         r = loadAllData(file, loadingSide);
     }
     file.close();
@@ -246,11 +415,87 @@ bool chessFile::loadHeaderAndTable(const std::string& path) {
     return r;
 }
 
+// Map the whole file, header, block table and data are used directly from the mapping
+bool chessFile::mapHeaderAndTable(const std::string& path) {
+    auto oldSide = createHeader();
+    auto loadingSide = Side::none;
+
+    i64 length = 0;
+    char* data = mapFile(path, length);
+    chess_STATS_ADD(fileOpens, 1);
+
+    bool r = data && header->readFile(data, length) && acceptHeader(path, oldSide, loadingSide);
+
+    if (r) {
+        auto sd = static_cast<int>(loadingSide);
+        unmap(sd);
+        pMap[sd] = data;
+        mapSize[sd] = length;
+
+        if (isCompressed()) {
+            auto blockCnt = getCompresseBlockCount();
+            i64 blockTableSz = blockCnt * sizeof(u32);
+            compressBlockTables[sd] = (u32*)(data + chess_HEADER_SIZE);
+            pCompressData[sd] = data + chess_HEADER_SIZE + blockTableSz;
+            r = chess_HEADER_SIZE + blockTableSz <= length
+                && chess_HEADER_SIZE + blockTableSz + (compressBlockTables[sd][blockCnt - 1] & ~chess_UNCOMPRESS_BIT) <= length;
+            startpos[sd] = endpos[sd] = 0;
+        } else {
+            r = chess_HEADER_SIZE + getSize() <= length;
+            pBuf[sd] = data + chess_HEADER_SIZE;
+            startpos[sd] = 0;
+            endpos[sd] = getSize();
+            resident[sd] = r;
+        }
+
+        if (!r) {
+            compressBlockTables[sd] = nullptr;
+            pCompressData[sd] = nullptr;
+            pBuf[sd] = nullptr;
+            startpos[sd] = endpos[sd] = 0;
+            unmap(sd);
+        }
+    } else if (data) {
+        unmapFile(data, length);
+    }
+
+    if (!r && chessVerbose) {
+        std::cerr << "Error: cannot map " << path << std::endl;
+    }
+
+    return r;
+}
+
+// memMode compressed: compressed data of the file is right after its block table
+bool chessFile::loadCompressedData(std::ifstream& file, Side side) {
+    auto sd = static_cast<int>(side);
+    if (pCompressData[sd]) {
+        free(pCompressData[sd]);
+    }
+
+    auto blockCnt = getCompresseBlockCount();
+    auto compDataSz = compressBlockTables[sd][blockCnt - 1] & ~chess_UNCOMPRESS_BIT;
+
+    pCompressData[sd] = (char*) malloc(compDataSz + 64);
+    if (pCompressData[sd] == nullptr || !file.read(pCompressData[sd], compDataSz)) {
+        free(pCompressData[sd]);
+        pCompressData[sd] = nullptr;
+        return false;
+    }
+    chess_STATS_ADD(bytesRead, compDataSz);
+    return true;
+}
+
 bool chessFile::loadAllData(std::ifstream& file, Side side) {
 
     auto sd = static_cast<int>(side);
     startpos[sd] = endpos[sd] = 0;
 
+    if (pBuf[sd]) {
+        free(pBuf[sd]);
+        pBuf[sd] = nullptr;
+    }
+
     if (isCompressed()) {
         auto blockCnt = getCompresseBlockCount();
         int blockTableSz = blockCnt * sizeof(u32);
@@ -264,15 +509,36 @@ bool chessFile::loadAllData(std::ifstream& file, Side side) {
 
         char* tempBuf = (char*) malloc(compDataSz + 64);
         if (file.read(tempBuf, compDataSz)) {
-            auto originSz = decompressAllBlocks(chess_SIZE_COMPRESS_BLOCK, blockCnt, compressBlockTables[sd], (char*)pBuf[sd], getSize(), tempBuf, compDataSz);
-            assert(originSz == getSize());
+            chess_STATS_ADD(bytesRead, compDataSz);
 
-            endpos[sd] = originSz;
+            int pieceCnt = 0;
+            for(int i = 0; i < 7; i++) {
+                pieceCnt += pieceCount[0][i] + pieceCount[1][i];
+            }
+
+            auto startTime = std::chrono::steady_clock::now();
+            auto originSz = pieceCnt >= chess_PARALLEL_DECOMPRESS_PIECES && decompressPool
+                ? decompressAllBlocksParallel(chess_SIZE_COMPRESS_BLOCK, blockCnt, compressBlockTables[sd], (char*)pBuf[sd], getSize(), tempBuf, compDataSz, getCodec(), *decompressPool)
+                : decompressAllBlocks(chess_SIZE_COMPRESS_BLOCK, blockCnt, compressBlockTables[sd], (char*)pBuf[sd], getSize(), tempBuf, compDataSz, getCodec());
+
+            if (chessVerbose) {
+                auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+                std::cout << "Decompressed " << getPath(sd) << ", " << originSz / (1024.0 * 1024) << " MB, "
+                          << originSz / (1024.0 * 1024) / MAX(elapsed, 1e-9) << " MB/s" << std::endl;
+            }
+
+            if (originSz == getSize()) {
+                endpos[sd] = originSz;
+            }
         }
 
         free(tempBuf);
-        free(compressBlockTables[sd]);
-        compressBlockTables[sd] = nullptr;
+
+        // Kept after a failure, the next request tries again
+        if (endpos[sd] > 0) {
+            free(compressBlockTables[sd]);
+            compressBlockTables[sd] = nullptr;
+        }
     } else {
         auto sz = getSize();
         createBuf(sz, sd);
@@ -280,23 +546,61 @@ bool chessFile::loadAllData(std::ifstream& file, Side side) {
         file.seekg(seekpos, std::ios::beg);
 
         if (file.read(pBuf[sd], sz)) {
+            chess_STATS_ADD(bytesRead, sz);
             endpos[sd] = sz;
         }
     }
 
-    return startpos[sd] < endpos[sd];
+    auto r = startpos[sd] < endpos[sd];
+    resident[sd].store(r, std::memory_order_release);
+    return r;
+}
+
+// memMode all: load the whole data of the side at its first request
+void chessFile::setSideData(Side side, char* data) {
+    auto sd = static_cast<int>(side);
+    chessLockGuard thelock(sdmtx[sd]);
+    assert(!isResident(sd) && pBuf[sd] == nullptr);
+
+    pBuf[sd] = data;
+    startpos[sd] = 0;
+    endpos[sd] = getSize();
+    resident[sd].store(true, std::memory_order_release);
+}
+
+bool chessFile::loadAllData(int sd) {
+    chessLockGuard thelock(sdmtx[sd]);
+    if (isResident(sd)) {
+        return true;
+    }
+
+    // No block table (it could not be loaded), nothing to decompress with
+    if (isCompressed() && compressBlockTables[sd] == nullptr) {
+        return false;
+    }
+
+    std::ifstream file(getPath(sd), std::ios::binary);
+    chess_STATS_ADD(fileOpens, 1);
+    bool r = file && loadAllData(file, static_cast<Side>(sd));
+
+    if (!r && chessVerbose) {
+        std::cerr << "Error: cannot read " << getPath(sd) << std::endl;
+    }
+    return r;
 }
 
 void chessFile::checkToLoadHeaderAndTable() {
-    if (header != nullptr && loadStatus != chessLoadStatus::none) {
+    if (loadStatus != chessLoadStatus::none && header != nullptr) {
         return;
     }
 
-    std::lock_guard<std::mutex> thelock(mtx);
-    if (header != nullptr && loadStatus != chessLoadStatus::none) {
+    chessLockGuard thelock(mtx);
+    if (loadStatus != chessLoadStatus::none && header != nullptr) {
         return;
     }
 
+    auto startTime = std::chrono::steady_clock::now();
+
     bool r = false;
     if (!path[0].empty() && !path[1].empty()) {
         r = loadHeaderAndTable(path[0]) && loadHeaderAndTable(path[1]);
@@ -305,85 +609,103 @@ void chessFile::checkToLoadHeaderAndTable() {
         r = loadHeaderAndTable(thepath);
     }
 
+    loadTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
     loadStatus = r ? chessLoadStatus::loaded : chessLoadStatus::error;
 }
 
-bool chessFile::readBuf(i64 idx, int sd)
+// Read a block into pDest, return its size or -1 if failed. It changes nothing of the file
+// thus many threads could read at the same time with their own buffers
+int chessFile::readBlock(i64 blockIdx, int sd, char* pDest, char* pCompressBuf) const
 {
-    if (!pBuf[sd]) {
-        createBuf(getBufSize(), sd);
-    }
-
-    auto bufCnt = MIN(getBufItemCnt(), getSize() - idx);
-    auto bufsz = bufCnt;
-
-    bool r = false;
-    std::ifstream file(getPath(sd), std::ios::binary);
-    if (file) {
-        if (memMode == chessMemMode::all) {
-            Side side = static_cast<Side>(sd);
-            r = loadAllData(file, side);
-        } else if (isCompressed() && compressBlockTables[sd]) {
-            r = readCompressedBlock(file, idx, sd, (char*)pBuf[sd]);
-        } else {
-            auto beginIdx = (idx + bufCnt <= getSize()) ? idx : 0;
-            auto x = beginIdx;
-            i64 seekpos = chess_HEADER_SIZE + x;
-            file.seekg(seekpos, std::ios::beg);
+    int r = -1;
 
-            if (file.read(pBuf[sd], bufsz)) {
-                startpos[sd] = beginIdx;
-                endpos[sd] = beginIdx + bufCnt;
-                r = true;
+    if (pCompressData[sd] || pMap[sd]) {
+        if (pCompressData[sd] && compressBlockTables[sd]) {
+            r = readCompressedBlock(pCompressData[sd], blockIdx, sd, pDest);
+        }
+    } else {
+        std::ifstream file(getPath(sd), std::ios::binary);
+        chess_STATS_ADD(fileOpens, 1);
+        if (file) {
+            if (isCompressed()) {
+                if (compressBlockTables[sd]) {
+                    r = readCompressedBlock(file, blockIdx, sd, pDest, pCompressBuf);
+                }
+            } else {
+                auto beginIdx = blockIdx * chess_SIZE_COMPRESS_BLOCK;
+                auto bufsz = (int)MIN((i64)chess_SIZE_COMPRESS_BLOCK, getSize() - beginIdx);
+                i64 seekpos = chess_HEADER_SIZE + beginIdx;
+                file.seekg(seekpos, std::ios::beg);
+
+                if (bufsz > 0 && file.read(pDest, bufsz)) {
+                    chess_STATS_ADD(bytesRead, bufsz);
+                    r = bufsz;
+                }
             }
         }
     }
 
-    file.close();
-
-    if (!r && chessVerbose) {
+    if (r < 0 && chessVerbose) {
         std::cerr << "Error: cannot read " << getPath(sd) << std::endl;
     }
 
     return r;
 }
 
-bool chessFile::readCompressedBlock(std::ifstream& file, i64 idx, int sd, char* pDest)
+int chessFile::readCompressedBlock(std::ifstream& file, i64 blockIdx, int sd, char* pDest, char* pCompressBuf) const
 {
     auto blockCnt = getCompresseBlockCount();
     int blockTableSz = blockCnt * sizeof(u32);
 
     const int blockSize = chess_SIZE_COMPRESS_BLOCK;
-    auto blockIdx = idx / blockSize;
-    startpos[sd] = endpos[sd] = blockIdx * blockSize;
+    auto startIdx = blockIdx * blockSize;
 
     auto iscompressed = !(compressBlockTables[sd][blockIdx] & chess_UNCOMPRESS_BIT);
     auto blockOffset = blockIdx == 0 ? 0 : (compressBlockTables[sd][blockIdx - 1] & ~chess_UNCOMPRESS_BIT);
 
-    auto compDataSz = (compressBlockTables[sd][blockIdx] & ~chess_UNCOMPRESS_BIT) - blockOffset;
+    auto compDataSz = (int)((compressBlockTables[sd][blockIdx] & ~chess_UNCOMPRESS_BIT) - blockOffset);
+    if (compDataSz <= 0 || compDataSz > chess_SIZE_COMPRESS_BLOCK * 3 / 2) {
+        return -1;
+    }
 
     i64 seekpos = chess_HEADER_SIZE + blockTableSz + blockOffset;
     file.seekg(seekpos, std::ios::beg);
 
     if (iscompressed) {
-        if (pCompressBuf == nullptr) {
-            pCompressBuf = (char*) malloc(chess_SIZE_COMPRESS_BLOCK * 3 / 2);
-        }
         if (file.read(pCompressBuf, compDataSz)) {
-            auto curBlockSize = (int)MIN(getSize() - startpos[sd], (i64)blockSize);
-            auto originSz = decompress(pDest, curBlockSize, pCompressBuf, compDataSz);
-            endpos[sd] += originSz;
-            return true;
+            chess_STATS_ADD(bytesRead, compDataSz);
+            auto curBlockSize = (int)MIN(getSize() - startIdx, (i64)blockSize);
+            return decompress(pDest, curBlockSize, pCompressBuf, compDataSz, getCodec());
         }
     } else if (file.read(pDest, compDataSz)) {
-        endpos[sd] += compDataSz;
-        return true;
+        chess_STATS_ADD(bytesRead, compDataSz);
+        return compDataSz;
     }
 
-    if (chessVerbose) {
-        std::cerr << "Error: cannot read " << getPath(sd) << std::endl;
+    return -1;
+}
+
+// pData points to the compressed data, right after the block table
+int chessFile::readCompressedBlock(const char* pData, i64 blockIdx, int sd, char* pDest) const
+{
+    const int blockSize = chess_SIZE_COMPRESS_BLOCK;
+    auto startIdx = blockIdx * blockSize;
+
+    auto iscompressed = !(compressBlockTables[sd][blockIdx] & chess_UNCOMPRESS_BIT);
+    auto blockOffset = blockIdx == 0 ? 0 : (compressBlockTables[sd][blockIdx - 1] & ~chess_UNCOMPRESS_BIT);
+
+    auto compDataSz = (int)((compressBlockTables[sd][blockIdx] & ~chess_UNCOMPRESS_BIT) - blockOffset);
+
+    if (iscompressed) {
+        auto curBlockSize = (int)MIN(getSize() - startIdx, (i64)blockSize);
+        return decompress(pDest, curBlockSize, pData + blockOffset, compDataSz, getCodec());
     }
-    return false;
+
+    if (compDataSz < 0 || compDataSz > chess_SIZE_COMPRESS_BLOCK) {
+        return -1;
+    }
+    memcpy(pDest, pData + blockOffset, compDataSz);
+    return compDataSz;
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -444,14 +766,69 @@ char chessFile::getCell(i64 idx, Side side)
 
     int sd = static_cast<int>(side);
 
-    if (!isDataReady(idx, sd)) {
-        if (!readBuf(idx, sd)) {
+    if (isResident(sd)) {
+        return pBuf[sd][idx];
+    }
+
+    if (memMode == chessMemMode::all) {
+        return loadAllData(sd) ? pBuf[sd][idx] : TB_MISSING;
+    }
+
+    return getBlockCell(idx, sd);
+}
+
+/*
+ * Each thread keeps its own last block, blocks are shared between threads
+ * only via the block cache, where they are copied in and out under shard locks
+ */
+class chessThreadBlock {
+public:
+    u32     fileId = 0;
+    int     sd = 0;
+    i64     startpos = 0, endpos = 0;
+
+    char    buf[chess_SIZE_COMPRESS_BLOCK];
+    char    compressBuf[chess_SIZE_COMPRESS_BLOCK * 3 / 2];
+};
+
+static thread_local chessThreadBlock threadBlock;
+
+char chessFile::getBlockCell(i64 idx, int sd)
+{
+    auto& tb = threadBlock;
+
+    if (tb.fileId != fileId || tb.sd != sd || idx < tb.startpos || idx >= tb.endpos) {
+        tb.fileId = 0;
+
+        // A cache of size 0 counts neither hits nor misses
+        auto cache = blockCache && blockCache->isEnabled() ? blockCache : nullptr;
+        auto blockIdx = idx / chess_SIZE_COMPRESS_BLOCK;
+        auto len = cache ? cache->get(fileId, sd, blockIdx, tb.buf) : -1;
+        if (cache) {
+            chess_STATS_ADD(blockCacheHits, len > 0);
+            chess_STATS_ADD(blockCacheMisses, len <= 0);
+        }
+        if (len <= 0) {
+            len = readBlock(blockIdx, sd, tb.buf, tb.compressBuf);
+            if (len <= 0) {
+                return TB_MISSING;
+            }
+            if (cache) {
+                cache->put(fileId, sd, blockIdx, tb.buf, len);
+            }
+        }
+
+        tb.fileId = fileId;
+        tb.sd = sd;
+        tb.startpos = blockIdx * chess_SIZE_COMPRESS_BLOCK;
+        tb.endpos = tb.startpos + len;
+
+        if (idx >= tb.endpos) {
             return TB_MISSING;
         }
     }
 
-    char ch = pBuf[sd][idx - startpos[sd]];
-    return ch;
+    return tb.buf[idx - tb.startpos];
 }
 
 char chessFile::getCell(const chessBoardCore& board, Side side) {
@@ -482,14 +859,9 @@ int chessFile::getScore(const chessBoardCore& board, Side side, bool useLock) {
     return getScore(r.key, side, useLock);
 }
 
-int chessFile::getScore(i64 idx, Side side, bool useLock)
+int chessFile::getScore(i64 idx, Side side, bool /*useLock*/)
 {
     checkToLoadHeaderAndTable();
-
-    if (useLock && (memMode != chessMemMode::all || !isDataReady(idx, static_cast<int>(side)))) {
-        std::lock_guard<std::mutex> thelock(sdmtx[static_cast<int>(side)]);
-        return getScoreNoLock(idx, side);
-    }
     return getScoreNoLock(idx, side);
 }
 
@@ -661,6 +1033,15 @@ i64 chessFile::setupIdxComputing(const std::string& name, int order, int version
 {
     size = chessFile::parseAttr(name.c_str(), idxArr, idxMult, (int*)pieceCount, order, version);
     enpassantable = pieceCount[0][static_cast<int>(PieceType::pawn)] > 0 && pieceCount[1][static_cast<int>(PieceType::pawn)] > 0;
+
+    // Specialised code takes pieces in name order, idxArr and idxMult are in the order of the header
+    keyEncoder = chessKey::findEncoder(name);
+    if (!order) {
+        order = 0 | 1 << 3 | 2 << 6 | 3 << 9 | 4 << 12 | 5 << 15;
+    }
+    for(int i = 0; i < 6 && idxArr[i] != chess_IDX_NONE; i++) {
+        keyMult[i] = idxMult[(order >> (i * 3)) & 0x7];
+    }
     return size;
 }
 
@@ -700,12 +1081,63 @@ std::string chessFile::pieceListToName(const Piece* pieceList) {
     return s;
 }
 
+// Same as chessBoardCore::materialKey of boards with that material, white pieces come first in names
+u64 chessFile::nameToMaterialKey(const std::string& name) {
+    u64 key = 0;
+    auto side = Side::white;
+
+    for(int i = 0; i < (int)name.size(); i++) {
+        auto p = strchr(pieceTypeName, name[i]);
+        if (p == nullptr || p - pieceTypeName > static_cast<int>(PieceType::pawn)) {
+            continue;
+        }
+        auto type = static_cast<PieceType>(p - pieceTypeName);
+        if (type == PieceType::king && i > 0) {
+            side = Side::black;
+        }
+        key += chessBoardCore::materialKeyOf(type, side);
+    }
+    return key;
+}
+
 chessKeyRec chessFile::getKey(const chessBoardCore& board) const {
+    return getPieceListKey(board.pieceList);
+}
+
+chessKeyRec chessFile::getPieceListKey(const Piece (*pieceList)[16]) const {
     chessKeyRec rec;
-    chessKey::getKey(rec, board, idxArr, idxMult, header ? header->order : 0);
+    if (keyEncoder) {
+        keyEncoder(rec, pieceList, keyMult);
+    } else {
+        chessKey::getKey(rec, pieceList, idxArr, idxMult, header ? header->order : 0);
+    }
     return rec;
 }
 
+void chessFile::getKeys(const chessBoardCore* const* boards, int cnt, chessKeyRec* recs) const {
+    static thread_local chessKeyBatch batch;
+    static thread_local std::vector<i64> keys;
+
+    // keyMult keeps 6 multipliers
+    if (!batch.setup(getName()) || batch.attrCnt > 6) {
+        for(int i = 0; i < cnt; i++) {
+            recs[i] = getPieceListKey(boards[i]->pieceList);
+        }
+        return;
+    }
+
+    for(int i = 0; i < cnt; i++) {
+        batch.add(boards[i]->pieceList);
+    }
+    keys.resize(cnt);
+    chessKey::getKeys(batch, keyMult, keys.data());
+
+    for(int i = 0; i < cnt; i++) {
+        recs[i].key = keys[i];
+        recs[i].flipSide = batch.flipSides[i];
+    }
+}
+
 extern const int tb_kIdxToPos[10];
 
 bool chessFile::setupBoard(chessBoardCore& board, i64 idx, FlipMode flip, Side firstsider) const
@@ -2,11 +2,26 @@
 #define chessFile_h
 
 #include <assert.h>
+#include <atomic>
 #include <fstream>
 #include <mutex>
 
 #include "chess.h"
 
+// Values of data cells, mating / losing cells keep distances to mate (in moves)
+#define TB_ILLEGAL              0
+#define TB_UNSET                1
+#define TB_MISSING              2
+#define TB_WINING               3
+#define TB_UNKNOWN              4
+#define TB_DRAW                 5
+
+#define TB_START_MATING         (TB_DRAW + 1)
+#define TB_START_LOSING         130
+
+#define TB_SPECIAL_DRAW         0
+#define TB_SPECIAL_START_MATING (TB_SPECIAL_DRAW + 1)
+#define TB_SPECIAL_START_LOSING 128
 
 namespace chess {
 
@@ -55,6 +70,14 @@ namespace chess {
             return false;
         }
 
+        bool readFile(const char* data, i64 length) {
+            if (data && length >= chess_HEADER_SIZE) {
+                memcpy((char*)&signature, data, chess_HEADER_SIZE);
+                return true;
+            }
+            return false;
+        }
+
         bool isSide(Side side) const {
             return property & (1 << static_cast<int>(side));
         }
@@ -73,6 +96,10 @@ namespace chess {
      * chess
      */
     class chessKeyRec;
+
+    // Key computing of an endgame, see chessKey::findEncoder
+    typedef void (*chessKeyEncoder)(chessKeyRec& rec, const Piece (*pieceList)[16], const i64* mult);
+
     class chessFile
     {
     public:
@@ -83,9 +110,18 @@ namespace chess {
         char*       pBuf[2];
 
         u32*        compressBlockTables[2];
-        char*       pCompressBuf;
 
-        chessLoadStatus  loadStatus;
+        // memMode == mapped: whole files mapped into memory
+        char*       pMap[2];
+        i64         mapSize[2];
+
+        // Compressed data (right after block tables) in memory, memMode compressed (own buffers) or mapped
+        char*       pCompressData[2];
+
+        std::atomic<chessLoadStatus> loadStatus;
+
+        // Seconds spent by the last loading of header, block tables (and data for memMode all)
+        std::atomic<double> loadTime;
 
     protected:
         std::string path[2];
@@ -98,17 +134,28 @@ namespace chess {
 
         int         idxArr[8];
         i64         idxMult[32];
+
+        // Specialised key computing, set with idxArr and idxMult (nullptr: generic code), its multipliers
+        chessKeyEncoder keyEncoder;
+        i64         keyMult[6];
         chessMemMode memMode;
 
         std::string chessName;
 
         bool        enpassantable;
 
+        // Decompressed blocks shared with other files, set by chessDb
+        u32         fileId;
+        chessBlockCache* blockCache;
+
+        // Threads decompressing whole sides of big endgames (memMode all), set by chessDb. None: one thread
+        chessThreadPool* decompressPool;
+
         std::mutex  mtx;
         std::mutex  sdmtx[2];
 
         chessFile();
-        ~chessFile();
+        virtual ~chessFile();
 
         static bool knownExtension(const std::string& path);
 
@@ -116,10 +163,15 @@ namespace chess {
 
         i64     getSize() const { return size; }
 
+        // Header and tables (and data for memMode all) have been loaded, or failed
+        bool    isReady() const { return loadStatus != chessLoadStatus::none; }
+        double  getLoadTime() const { return loadTime; }
+
         int getCompresseBlockCount() const {
             return (int)((getSize() + chess_SIZE_COMPRESS_BLOCK - 1) / chess_SIZE_COMPRESS_BLOCK);
         }
         bool    isCompressed() const { return header->property & chess_PROP_COMPRESSED; }
+        chessCodec getCodec() const { return header->property & chess_PROP_LZ4 ? chessCodec::lz4 : chessCodec::lzma; }
 
         int        getProperty() const { return header->property; }
         void    addProperty(int addprt) { header->property |= addprt; }
@@ -133,27 +185,37 @@ namespace chess {
         static i64 parseAttr(const std::string& name, int* idxArr, i64* idxMult, int* pieceCount, u16 order, int version);
 
         static i64 computeSize(const std::string &name);
+
+        // Endgame name from the path of a side file, such as krkpw.zmt -> krkp
+        static std::string pathToName(const std::string& path);
+
+        // Cell of a score in the normal range (not chess_PROP_SPECIAL_SCORE_RANGE), TB_UNSET if it could not be kept
+        static char scoreToCell(int score);
+
+        // Writes cells of a side as LZ4 compressed blocks. Header keeps name and copyright, side, properties
+        // and dtm_max are set from the data
+        static bool saveSideFile(const std::string& path, chessFileHeader header, Side side, const char* data, i64 size);
+
         //        static i64 computeMaterialSigns(const std::string &name, u32 order);
         //        static i64 computeMaterialSigns(const std::string &name, int* idxArr, i64* idxMult, u16 order);
 
     protected:
         static i64 parseAttr(const int* idxArr, i64* idxMult, int* pieceCount, const int* orderArray, bool enpassantable);
 
-        bool    readBuf(i64 startpos, int sd);
+        int     readBlock(i64 blockIdx, int sd, char* pDest, char* pCompressBuf) const;
         bool    isDataReady(i64 pos, int sd) const { return pos >= startpos[sd] && pos < endpos[sd] && pBuf[sd]; }
 
-        bool    createBuf(i64 len, int sd);
+        // Whole data of the side is in pBuf and won't be changed anymore, reading needs no lock
+        bool    isResident(int sd) const { return resident[sd].load(std::memory_order_acquire); }
+        std::atomic<bool> resident[2];
 
-        i64     getBufItemCnt() const {
-            if (memMode == chessMemMode::tiny) {
-                return chess_SIZE_COMPRESS_BLOCK;
-            }
-            return getSize();
+        bool    isMapped(const void* p, int sd) const {
+            return pMap[sd] && (const char*)p >= pMap[sd] && (const char*)p < pMap[sd] + mapSize[sd];
         }
 
-        i64     getBufSize() const {
-            return getBufItemCnt();
-        }
+        void    unmap(int sd);
+
+        bool    createBuf(i64 len, int sd);
 
         int    pieceCount[2][7];
 
@@ -165,11 +227,25 @@ namespace chess {
     public:
         virtual chessKeyRec getKey(const chessBoardCore& board) const;
 
+        // Non-virtual version of getKey, for templated probe paths
+        chessKeyRec getPieceListKey(const Piece (*pieceList)[16]) const;
+
+        // Keys of many boards of this endgame at once, see chessKey::getKeys
+        void    getKeys(const chessBoardCore* const* boards, int cnt, chessKeyRec* recs) const;
+
+        // Safe to call from many threads at the same time, useLock is kept for compatibility only
         int     getScore(i64 idx, Side side, bool useLock = true);
         int     getScore(const chessBoardCore& board, Side side, bool useLock = true);
 
         virtual void    checkToLoadHeaderAndTable();
 
+        // The side is in the file or set by setSideData
+        bool    hasSide(Side side) const { return header->isSide(side) || isResident(static_cast<int>(side)); }
+
+        // Cells (normal range) of a side which is not in the file, such as derived from the other side.
+        // The file takes the buffer (malloc), it is released by removeBuffers
+        void    setSideData(Side side, char* data);
+
         bool    setupBoard(chessBoardCore& board, i64 idx, FlipMode flip, Side strongsider) const;
 
     protected:
@@ -178,22 +254,33 @@ namespace chess {
 
     public:
         bool    preload(const std::string& _path, chessMemMode mode, chessLoadMode loadMode);
+        // Header and block table given by a catalog (chessCatalog), the same as loading with memMode tiny
+        bool    preload(const std::string& _path, const char* headerData, const u32* blockTable, i64 blockCnt);
         bool    loadHeaderAndTable(const std::string& path);
-        virtual void    merge(chessFile& otherchessFile);
+        bool    mapHeaderAndTable(const std::string& path);
+        virtual bool    merge(chessFile& otherchessFile);
 
         int     cellToScore(char cell);
 
     protected:
         char    getCell(const chessBoardCore& board, Side side);
         char    getCell(i64 idx, Side side);
+        char    getBlockCell(i64 idx, int sd);
+
+        Side    createHeader();
+        bool    acceptHeader(const std::string& path, Side oldSide, Side& loadingSide);
 
+        bool    loadAllData(int sd);
         bool    loadAllData(std::ifstream& file, Side side);
-        bool    readCompressedBlock(std::ifstream& file, i64 idx, int sd, char* pDest);
+        bool    loadCompressedData(std::ifstream& file, Side side);
+        int     readCompressedBlock(std::ifstream& file, i64 blockIdx, int sd, char* pDest, char* pCompressBuf) const;
+        int     readCompressedBlock(const char* pData, i64 blockIdx, int sd, char* pDest) const;
 
         // May remove
     public:
         //        static u64 pieceListToMaterialSign(const Piece* pieceList);
         static std::string pieceListToName(const Piece* pieceList);
+        static u64 nameToMaterialKey(const std::string& name);
 
     };
 
@@ -0,0 +1,515 @@
+#include <algorithm>
+#include <functional>
+#include <future>
+#include <iostream>
+
+#include "chess.h"
+#include "chessgen.h"
+
+using namespace chess;
+
+// Entries of a task, a multiple of 64 thus tasks never share words of bitmaps
+#define chess_GEN_CHUNK         (1 << 16)
+
+// Longest distances (plies) the cells could keep
+#define chess_GEN_MAX_WIN_PLY   ((TB_START_LOSING - TB_START_MATING) * 2 - 1)
+#define chess_GEN_MAX_LOSS_PLY  ((255 - TB_START_LOSING) * 2)
+
+static u8 scoreToCell(int score) {
+    return (u8)chessFile::scoreToCell(score);
+}
+
+static int cellToScore(u8 cell) {
+    if (cell == TB_DRAW) {
+        return chess_SCORE_DRAW;
+    }
+    if (cell >= TB_START_LOSING) {
+        return -chess_SCORE_MATE + (cell - TB_START_LOSING) * 2;
+    }
+    assert(cell >= TB_START_MATING);
+    return chess_SCORE_MATE - (cell - TB_START_MATING) * 2 - 1;
+}
+
+// Score of the parent from the best score of its children
+static int parentScore(int bestChildScore) {
+    auto score = -bestChildScore;
+    if (score != chess_SCORE_DRAW) {
+        score += score > 0 ? -1 : +1;
+    }
+    return score;
+}
+
+// Side to move could capture en passant the pawn which has just been pushed two squares
+static bool canCaptureEnpassant(const chessBoardCore& board, Side side) {
+    if (board.enpassant <= 0) {
+        return false;
+    }
+    auto dest = board.enpassant + (side == Side::white ? +8 : -8);
+    auto col = COL(dest);
+    return (col > 0 && board.isPiece(dest - 1, PieceType::pawn, side))
+        || (col < 7 && board.isPiece(dest + 1, PieceType::pawn, side));
+}
+
+chessGenerator::chessGenerator(chessDb& _db, int threadCnt) : db(_db), pool(threadCnt) {
+    size = 0;
+    materialKey = flipMaterialKey = 0;
+    symmetric = false;
+    missing = false;
+    maxExitPly = 0;
+}
+
+void chessGenerator::clear() {
+    for(int sd = 0; sd < 2; sd++) {
+        cells[sd].clear();
+        exitCells[sd].clear();
+        candidates[sd].clear();
+        exitPendings[sd].clear();
+        epSensitives[sd].clear();
+        aliases[sd].clear();
+    }
+    idxFile.reset();
+    size = 0;
+}
+
+chessGenerator::Entry chessGenerator::getEntry(const chessBoardCore& board, Side side) const {
+    auto rec = idxFile->getKey(board);
+
+    Entry entry;
+    entry.idx = rec.key;
+    entry.sd = rec.flipSide ? 1 - static_cast<int>(side) : static_cast<int>(side);
+
+    if (testBit(aliases[entry.sd], entry.idx)) {
+        return getMasterEntry(board.pieceList, side);
+    }
+    return entry;
+}
+
+// The smallest entry of all symmetric images: mirrors (pawnless: rotations too) and, for the same
+// material of both sides, swapping colors
+chessGenerator::Entry chessGenerator::getMasterEntry(const Piece (*pieceList)[16], Side side) const {
+    Entry master = { 2, -1 };
+    Piece imageList[2][16];
+
+    auto transformCnt = havingPawns ? 2 : 8;
+    for(int colorSwap = 0; colorSwap < (symmetric ? 2 : 1); colorSwap++) {
+        for(int t = 0; t < transformCnt; t++) {
+            for(int sd = 0; sd < 2; sd++) {
+                auto toSd = colorSwap ? 1 - sd : sd;
+                for(int i = 0; i < 16; i++) {
+                    auto piece = pieceList[sd][i];
+                    if (!piece.isEmpty()) {
+                        auto pos = piece.idx;
+                        if (t & 1) pos ^= 7;                            // mirror files
+                        if (t & 2) pos ^= 56;                           // mirror ranks
+                        if (t & 4) pos = (COL(pos) << 3) | ROW(pos);    // mirror the diagonal a8-h1
+                        if (colorSwap) {
+                            pos ^= 56;
+                            piece.side = getXSide(piece.side);
+                        }
+                        piece.idx = pos;
+                    }
+                    imageList[toSd][i] = piece;
+                }
+            }
+
+            auto rec = idxFile->getPieceListKey(imageList);
+            auto sd = static_cast<int>(side) ^ colorSwap ^ (rec.flipSide ? 1 : 0);
+            if (rec.key < master.idx || master.idx < 0 || (rec.key == master.idx && sd < master.sd)) {
+                master = { sd, rec.key };
+            }
+        }
+    }
+    return master;
+}
+
+void chessGenerator::runChunks(const std::function<void(i64, i64, std::vector<Entry>&)>& fn, std::vector<Entry>& entries) {
+    auto chunkCnt = (size + chess_GEN_CHUNK - 1) / chess_GEN_CHUNK;
+    std::vector<std::vector<Entry>> chunkEntries(chunkCnt);
+    std::vector<std::future<void>> futures;
+
+    for(i64 k = 0; k < chunkCnt; k++) {
+        futures.push_back(pool.submit([&, k]() {
+            fn(k * chess_GEN_CHUNK, MIN(size, (k + 1) * chess_GEN_CHUNK), chunkEntries[k]);
+        }));
+    }
+    for(auto && future : futures) {
+        future.wait();
+    }
+
+    entries.clear();
+    for(auto && vec : chunkEntries) {
+        entries.insert(entries.end(), vec.begin(), vec.end());
+    }
+}
+
+//////////////////////////////////////////////////////////////////////
+// Generating
+//////////////////////////////////////////////////////////////////////
+bool chessGenerator::generate(const std::string& _name, const std::string& folder, int sideMask) {
+    clear();
+
+    name = _name;
+    toLower(name);
+
+    idxFile.reset(new chessFile());
+    size = idxFile->setupIdxComputing(name, 0, 0);
+    if (size <= 0) {
+        return false;
+    }
+
+    materialKey = chessFile::nameToMaterialKey(name);
+    flipMaterialKey = chessBoardCore::flipMaterialKey(materialKey);
+    symmetric = materialKey == flipMaterialKey;
+    havingPawns = name.find('p') != std::string::npos;
+    missing = false;
+    maxExitPly = 0;
+
+    auto wordCnt = (size + 63) / 64;
+    for(int sd = 0; sd < 2; sd++) {
+        cells[sd].assign(size, TB_UNSET);
+        exitCells[sd].assign(size, TB_UNSET);
+        candidates[sd] = std::vector<std::atomic<u64>>(wordCnt);
+        exitPendings[sd].assign(wordCnt, 0);
+        epSensitives[sd].assign(wordCnt, 0);
+        aliases[sd].assign(wordCnt, 0);
+    }
+
+    // Mates, stalemates, illegal positions and the best ones of captures / promotions
+    std::vector<Entry> entries;
+    runChunks([this](i64 fromIdx, i64 toIdx, std::vector<Entry>& newEntries) {
+        initRange(fromIdx, toIdx, newEntries);
+    }, entries);
+
+    if (missing) {
+        return false;
+    }
+
+    if (chessVerbose) {
+        std::cout << name << ": size " << size << ", mates " << entries.size() << ", longest exit " << maxExitPly << std::endl;
+    }
+
+    for(int ply = 1, lastPly = 0; ; ply++) {
+        for(int sd = 0; sd < 2; sd++) {
+            for(auto && word : candidates[sd]) {
+                word.store(0, std::memory_order_relaxed);
+            }
+        }
+
+        // Predecessors of the last round
+        auto sliceCnt = MIN((i64)entries.size(), (i64)pool.getThreadCnt() * 4);
+        std::vector<std::future<void>> futures;
+        for(i64 k = 0; k < sliceCnt; k++) {
+            auto from = (i64)entries.size() * k / sliceCnt, to = (i64)entries.size() * (k + 1) / sliceCnt;
+            futures.push_back(pool.submit([this, &entries, from, to]() {
+                markPredecessors(entries, from, to);
+            }));
+        }
+        for(auto && future : futures) {
+            future.wait();
+        }
+
+        // Cells are changed after deciding since other tasks read them
+        runChunks([this, ply](i64 fromIdx, i64 toIdx, std::vector<Entry>& newEntries) {
+            decideRange(ply, fromIdx, toIdx, newEntries);
+        }, entries);
+
+        if (entries.empty()) {
+            if (ply > lastPly + 1 && ply > maxExitPly) {
+                break;
+            }
+            continue;
+        }
+
+        if (ply > ((ply & 1) ? chess_GEN_MAX_WIN_PLY : chess_GEN_MAX_LOSS_PLY)) {
+            std::cerr << "Error: " << name << " has distances to mate too long to keep" << std::endl;
+            return false;
+        }
+
+        auto cell = scoreToCell((ply & 1) ? chess_SCORE_MATE - ply : -chess_SCORE_MATE + ply);
+        for(auto && entry : entries) {
+            cells[entry.sd][entry.idx] = cell;
+        }
+        lastPly = ply;
+
+        if (chessVerbose) {
+            std::cout << name << ": ply " << ply << ", " << ((ply & 1) ? "wins " : "losses ") << entries.size() << std::endl;
+        }
+    }
+
+    // The rest are draws, then copy cells of same positions
+    runChunks([this](i64 fromIdx, i64 toIdx, std::vector<Entry>&) {
+        for(int sd = 0; sd < 2; sd++) {
+            std::replace(cells[sd].begin() + fromIdx, cells[sd].begin() + toIdx, (u8)TB_UNSET, (u8)TB_DRAW);
+        }
+    }, entries);
+
+    runChunks([this](i64 fromIdx, i64 toIdx, std::vector<Entry>&) {
+        finishRange(fromIdx, toIdx);
+    }, entries);
+
+    for(int sd = 0; sd < 2; sd++) {
+        if ((sideMask & (1 << sd)) && !save(folder, sd)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void chessGenerator::initRange(i64 fromIdx, i64 toIdx, std::vector<Entry>& newEntries) {
+    chessProbeBoard board;
+    MoveList moveList;
+    Hist hist;
+
+    for(auto idx = fromIdx; idx < toIdx; idx++) {
+        if (!idxFile->setupBoard(board, idx, FlipMode::none, Side::white)) {
+            cells[B][idx] = cells[W][idx] = TB_ILLEGAL;
+            continue;
+        }
+
+        for(int sd = 0; sd < 2; sd++) {
+            auto side = static_cast<Side>(sd), xside = getXSide(side);
+            if (board.isIncheck(xside)) {
+                cells[sd][idx] = TB_ILLEGAL;
+                continue;
+            }
+
+            // Same as another entry, copied at the end
+            auto master = getMasterEntry(board.pieceList, side);
+            if (master.idx != idx || master.sd != sd) {
+                cells[sd][idx] = TB_UNKNOWN;
+                setBit(aliases[sd], idx);
+                continue;
+            }
+
+            board.side = side;
+            moveList.reset();
+            board.gen(moveList, side, false);
+
+            int legalCnt = 0, bestExit = -chess_SCORE_MATE - 1;
+            bool epSensitive = false;
+
+            for(int i = 0; i < moveList.end; i++) {
+                board.make(moveList.list[i], hist);
+                if (!board.isIncheck(side)) {
+                    legalCnt++;
+                    if (!isInTable(board)) {
+                        bestExit = MAX(bestExit, -probeExit(board, xside));
+                    } else if (canCaptureEnpassant(board, xside)) {
+                        epSensitive = true;
+                    }
+                }
+                board.takeBack(hist);
+            }
+
+            if (legalCnt == 0) {
+                if (board.isIncheck(side)) {
+                    cells[sd][idx] = TB_START_LOSING;
+                    newEntries.push_back({ sd, idx });
+                } else {
+                    cells[sd][idx] = TB_DRAW;
+                }
+                continue;
+            }
+
+            if (bestExit >= -chess_SCORE_MATE) {
+                auto score = parentScore(-bestExit);
+                exitCells[sd][idx] = scoreToCell(score);
+                if (score != chess_SCORE_DRAW) {
+                    setBit(exitPendings[sd], idx);
+
+                    auto ply = chess_SCORE_MATE - abs(score);
+                    for(auto m = maxExitPly.load(); m < ply && !maxExitPly.compare_exchange_weak(m, ply); ) {
+                    }
+                }
+            }
+
+            if (epSensitive) {
+                setBit(epSensitives[sd], idx);
+            }
+        }
+    }
+}
+
+// Parents of entries by quiet un-moves of the side which has just moved, en passant sensitive parents
+// are skipped since they are verified by their moves in every round
+void chessGenerator::markPredecessors(const std::vector<Entry>& entries, i64 from, i64 to) {
+    chessProbeBoard board;
+    RetroMoveList moveList;
+    Hist hist;
+
+    for(auto k = from; k < to; k++) {
+        auto& entry = entries[k];
+        idxFile->setupBoard(board, entry.idx, FlipMode::none, Side::white);
+
+        auto side = static_cast<Side>(entry.sd), xside = getXSide(side);
+        board.side = xside;
+
+        // Quiet un-moves only, the others lead out of the endgame
+        moveList.reset();
+        board.genRetro(moveList, xside, false, false);
+        for(int i = 0; i < moveList.end; i++) {
+            auto& move = moveList.list[i].move;
+
+            // Parents after a double push the opponent could capture en passant are solved by their moves
+            if (move.type == PieceType::pawn && abs(move.from - move.dest) == 16) {
+                auto col = COL(move.dest);
+                if ((col > 0 && board.isPiece(move.dest - 1, PieceType::pawn, side)) || (col < 7 && board.isPiece(move.dest + 1, PieceType::pawn, side))) {
+                    continue;
+                }
+            }
+
+            board.unmake(moveList.list[i], hist);
+            if (!board.isIncheck(side)) {
+                auto parent = getEntry(board, xside);
+                candidates[parent.sd][parent.idx >> 6].fetch_or(1ULL << (parent.idx & 63), std::memory_order_relaxed);
+            }
+            board.remake(hist);
+        }
+    }
+}
+
+void chessGenerator::decideRange(int ply, i64 fromIdx, i64 toIdx, std::vector<Entry>& newEntries) {
+    chessProbeBoard board;
+
+    auto winning = (ply & 1) != 0;
+    auto targetScore = winning ? chess_SCORE_MATE - ply : -chess_SCORE_MATE + ply;
+    auto targetCell = scoreToCell(targetScore);
+
+    for(auto w = fromIdx >> 6; w < (toIdx + 63) >> 6; w++) {
+        for(int sd = 0; sd < 2; sd++) {
+            auto candidateBits = candidates[sd][w].load(std::memory_order_relaxed);
+            auto bits = candidateBits | exitPendings[sd][w] | epSensitives[sd][w];
+
+            while (bits) {
+                auto bit = popFirstBit(bits);
+                auto idx = (w << 6) + bit;
+                if (cells[sd][idx] != TB_UNSET) {
+                    continue;
+                }
+
+                auto isCandidate = (candidateBits >> bit) & 1;
+                auto exitDecides = exitCells[sd][idx] == targetCell;
+                if (winning && (isCandidate || exitDecides)) {
+                    newEntries.push_back({ sd, idx });
+                    continue;
+                }
+
+                if (isCandidate || exitDecides || testBit(epSensitives[sd], idx)) {
+                    idxFile->setupBoard(board, idx, FlipMode::none, Side::white);
+                    board.side = static_cast<Side>(sd);
+                    if (evaluate(board, board.side, ply, &exitCells[sd][idx]) == targetScore) {
+                        newEntries.push_back({ sd, idx });
+                    }
+                }
+            }
+        }
+    }
+}
+
+void chessGenerator::finishRange(i64 fromIdx, i64 toIdx) {
+    chessProbeBoard board;
+
+    for(auto idx = fromIdx; idx < toIdx; idx++) {
+        if (cells[B][idx] != TB_UNKNOWN && cells[W][idx] != TB_UNKNOWN) {
+            continue;
+        }
+
+        idxFile->setupBoard(board, idx, FlipMode::none, Side::white);
+        for(int sd = 0; sd < 2; sd++) {
+            if (cells[sd][idx] == TB_UNKNOWN) {
+                auto entry = getMasterEntry(board.pieceList, static_cast<Side>(sd));
+                assert(cells[entry.sd][entry.idx] != TB_UNKNOWN);
+                cells[sd][idx] = cells[entry.sd][entry.idx];
+            }
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////
+// Scores
+//////////////////////////////////////////////////////////////////////
+
+// Score of the board by its moves, from cells solved by previous rounds and sub-endgames.
+// Unsolved positions are ones of ply or longer, the score is chess_SCORE_UNKNOWN if they could change it
+int chessGenerator::evaluate(chessProbeBoard& board, Side side, int ply, const u8* exitCell) const {
+    auto xside = getXSide(side);
+
+    MoveList moveList;
+    Hist hist;
+    board.gen(moveList, side, false);
+
+    int best = -chess_SCORE_MATE - 1, legalCnt = 0;
+    bool unknown = false;
+
+    for(int i = 0; i < moveList.end; i++) {
+        board.make(moveList.list[i], hist);
+        if (!board.isIncheck(side)) {
+            legalCnt++;
+
+            // Captures and promotions are in exitCell if it is given
+            auto inTable = isInTable(board);
+            if (inTable || exitCell == nullptr) {
+                auto score = inTable ? childScore(board, xside, ply) : probeExit(board, xside);
+                if (score == chess_SCORE_UNKNOWN) {
+                    unknown = true;
+                } else {
+                    best = MAX(best, -score);
+                }
+            }
+        }
+        board.takeBack(hist);
+    }
+
+    if (legalCnt == 0) {
+        return board.isIncheck(side) ? -chess_SCORE_MATE : chess_SCORE_DRAW;
+    }
+
+    if (best >= -chess_SCORE_MATE) {
+        best = parentScore(-best);
+    }
+    if (exitCell && *exitCell != TB_UNSET) {
+        best = MAX(best, cellToScore(*exitCell));
+    }
+
+    if (unknown) {
+        // Unsolved moves could win in ply + 1 plies or longer only
+        return best > 0 && chess_SCORE_MATE - best <= ply + 1 ? best : chess_SCORE_UNKNOWN;
+    }
+    return best;
+}
+
+int chessGenerator::childScore(chessProbeBoard& board, Side side, int ply) const {
+    if (canCaptureEnpassant(board, side)) {
+        return evaluate(board, side, ply, nullptr);
+    }
+
+    auto entry = getEntry(board, side);
+    auto cell = cells[entry.sd][entry.idx];
+    assert(cell != TB_ILLEGAL && cell != TB_UNKNOWN);
+    return cell == TB_UNSET ? chess_SCORE_UNKNOWN : cellToScore(cell);
+}
+
+int chessGenerator::probeExit(chessProbeBoard& board, Side side) const {
+    auto score = db.getScore(board, side);
+    if (abs(score) <= chess_SCORE_MATE) {
+        return score;
+    }
+
+    if (!board.pieceList_isDraw() && !missing.exchange(true)) {
+        std::cerr << "Error: missing endgame " << chessFile::pieceListToName((const Piece*)board.pieceList) << " for " << name << std::endl;
+    }
+    return chess_SCORE_DRAW;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Saving
+//////////////////////////////////////////////////////////////////////
+bool chessGenerator::save(const std::string& folder, int sd) const {
+    chessFileHeader header;
+    header.reset();
+    strncpy(header.name, name.c_str(), sizeof(header.name) - 1);
+    strncpy(header.copyright, "Copyright 2017 by Nguyen Hong Pham", sizeof(header.copyright) - 1);
+
+    auto path = folder + "/" + name + (sd == W ? "w" : "b") + ".zmt";
+    return chessFile::saveSideFile(path, header, static_cast<Side>(sd), (const char*)cells[sd].data(), size);
+}
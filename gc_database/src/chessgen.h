@@ -0,0 +1,101 @@
+#ifndef chessGen_h
+#define chessGen_h
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "chess.h"
+#include "chesspool.h"
+
+namespace chess {
+
+    /*
+     * Retrograde generator of endgames, by rounds of plies:
+     * - positions lost in the last round mark their predecessors (quiet un-moves inside the endgame) as won
+     * - positions won in the last round mark their predecessors as candidates of losing, which are
+     *   verified by their moves
+     * Captures and promotions lead to sub-endgames, they are probed from chessDb once at the start.
+     * Indexes are the ones of chessFile (parseAttr, setupBoard, chessKey)
+     */
+    class chessGenerator {
+    public:
+        // Sub-endgames are probed from db, threadCnt 0: number of cores
+        chessGenerator(chessDb& db, int threadCnt = 0);
+
+        // Name such as "kqkr", files <name>w.zmt / <name>b.zmt are written into folder for sides of sideMask
+        bool    generate(const std::string& name, const std::string& folder, int sideMask = (1 << W) | (1 << B));
+
+        int     getThreadCnt() const { return pool.getThreadCnt(); }
+
+    private:
+        chessDb& db;
+        chessThreadPool pool;
+
+        std::unique_ptr<chessFile> idxFile;
+        std::string name;
+        u64     materialKey, flipMaterialKey;
+        bool    symmetric;
+        i64     size;
+
+        // Cells of both sides, TB_UNSET: not solved yet, TB_UNKNOWN: same as another entry
+        std::vector<u8> cells[2];
+
+        // Best score by captures and promotions, as a cell, TB_UNSET: none
+        std::vector<u8> exitCells[2];
+
+        // One bit per entry
+        std::vector<std::atomic<u64>> candidates[2];
+        std::vector<u64> exitPendings[2];   // exit cells of wins or losses, they are waiting for their rounds
+        std::vector<u64> epSensitives[2];   // having a pawn double push the opponent could capture en passant
+
+        // Keys of chessKey are not unique for symmetric positions (such as kings on a diagonal), entries of a
+        // position are solved at the smallest one (master) only, the others are aliases
+        std::vector<u64> aliases[2];
+        bool    havingPawns;
+
+        mutable std::atomic<bool> missing;
+        std::atomic<int> maxExitPly;
+
+        class Entry {
+        public:
+            int sd;
+            i64 idx;
+        };
+
+        void    clear();
+
+        // Calls fn for ranges of entries on threads of the pool, entries returned by fn are joined
+        void    runChunks(const std::function<void(i64, i64, std::vector<Entry>&)>& fn, std::vector<Entry>& entries);
+
+        bool    isInTable(const chessBoardCore& board) const {
+            return board.materialKey == materialKey || board.materialKey == flipMaterialKey;
+        }
+
+        Entry   getEntry(const chessBoardCore& board, Side side) const;
+        Entry   getMasterEntry(const Piece (*pieceList)[16], Side side) const;
+
+        void    initRange(i64 fromIdx, i64 toIdx, std::vector<Entry>& newEntries);
+        void    markPredecessors(const std::vector<Entry>& entries, i64 from, i64 to);
+        void    decideRange(int ply, i64 fromIdx, i64 toIdx, std::vector<Entry>& newEntries);
+        void    finishRange(i64 fromIdx, i64 toIdx);
+
+        int     evaluate(chessProbeBoard& board, Side side, int ply, const u8* exitCell) const;
+        int     childScore(chessProbeBoard& board, Side side, int ply) const;
+        int     probeExit(chessProbeBoard& board, Side side) const;
+
+        bool    save(const std::string& folder, int sd) const;
+
+        static bool testBit(const std::vector<u64>& bits, i64 idx) {
+            return bits[idx >> 6] & (1ULL << (idx & 63));
+        }
+        static void setBit(std::vector<u64>& bits, i64 idx) {
+            bits[idx >> 6] |= 1ULL << (idx & 63);
+        }
+    };
+
+} // namespace chess
+
+#endif /* chessGen_h */
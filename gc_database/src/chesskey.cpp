@@ -1,3 +1,11 @@
+#include <cstring>
+#include <utility>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define chess_KEY_AVX2
+#include <immintrin.h>
+#endif
+
 #include "chess.h"
 #include "chessKey.h"
 
@@ -34,42 +42,72 @@ static const int tb_kIdx[64] = {
     -1,-1,-1,-1, -1,-1,-1,-1
 };
 
-static int* tb_xx, *tb_xxx, *tb_xxxx;
-static int* tb_pp, *tb_ppp, *tb_pppp;
 int *kk_2, *kk_8;
 
+// Index of king pairs (k0 << 6 | k1), -1 for invalid pairs. One more entry thus 32-bit gathers of the last pair stay inside
+static i16 kkIdx_2[64 * 64 + 1], kkIdx_8[64 * 64 + 1];
+
 const int tb_kIdxToPos[10] = {
     0, 1, 2, 3, 9, 10, 11, 18, 19, 27
 };
 
-static int bSearch(const int* array, int sz, int key) {
-    int i = 0, j = sz - 1;
-
-    while (i <= j) {
-        int idx = (i + j) / 2;
-        if (key == array[idx]) {
-            return idx;
+/*
+ * Binomial coefficients C(n, k), n <= 64, k <= 4
+ */
+class chessBinomial {
+public:
+    int c[65][5];
+
+    constexpr chessBinomial() : c() {
+        for(int n = 0; n <= 64; n++) {
+            c[n][0] = 1;
+            for(int k = 1; k <= 4; k++) {
+                c[n][k] = n == 0 ? 0 : c[n - 1][k - 1] + c[n - 1][k];
+            }
         }
-        if (key < array[idx]) j = idx - 1;
-        else i = idx + 1;
     }
+};
+
+static constexpr chessBinomial binomial;
 
-    return -1;
+static_assert(binomial.c[64][2] == chess_SIZE_XX && binomial.c[64][3] == chess_SIZE_XXX && binomial.c[64][4] == chess_SIZE_XXXX, "wrong binomial table");
+static_assert(binomial.c[48][2] == chess_SIZE_PP && binomial.c[48][3] == chess_SIZE_PPP && binomial.c[48][4] == chess_SIZE_PPPP, "wrong binomial table");
+
+/*
+ * Combinations of k squares out of n (p[0] < p[1] < ... < p[k - 1]) are ranked in lexicographic order,
+ * the same order they were listed in old tables. By mapping square x to n - 1 - x that order is
+ * the reverse of colexicographic order, which could be ranked by a sum of binomials
+ */
+static inline int rankCombination(const int* p, int k, int n) {
+    int r = binomial.c[n][k] - 1;
+    for(int i = 0; i < k; i++) {
+        r -= binomial.c[n - 1 - p[i]][k - i];
+    }
+    return r;
 }
 
-static void sort_tbkeys(int* tbkeys, int sz) {
-    std::qsort(tbkeys, sz, sizeof(int), [](const void* a, const void* b) {
-        const int* x = static_cast<const int*>(a);
-        const int* y = static_cast<const int*>(b);
-        return (int)(*x - *y);
-    });
+static inline void unrankCombination(int* p, int k, int n, int rank) {
+    int m = binomial.c[n][k] - 1 - rank;
+    for(int i = 0, b = n - 1; i < k; i++, b--) {
+        while (binomial.c[b][k - i] > m) {
+            b--;
+        }
+        m -= binomial.c[b][k - i];
+        p[i] = n - 1 - b;
+    }
 }
 
+#define SORT2(a, b) if ((a) > (b)) { auto t = a; a = b; b = t; }
+
 void chessKey::createKingKeys() {
     kk_8 = new int[chess_SIZE_KK8];
     int x = 0;
 
-    for(int i = 0; i < sizeof(tb_kIdxToPos) / sizeof(int); i++) {
+    for(int i = 0; i <= 64 * 64; i++) {
+        kkIdx_2[i] = kkIdx_8[i] = -1;
+    }
+
+    for(int i = 0; i < (int)(sizeof(tb_kIdxToPos) / sizeof(tb_kIdxToPos[0])); i++) {
         int k0 = tb_kIdxToPos[i];
         int r0 = ROW(k0), f0 = COL(k0);
         for(int k1 = 0; k1 < 64; k1++) {
@@ -77,6 +115,7 @@ void chessKey::createKingKeys() {
                 continue;
             }
 
+            kkIdx_8[k0 << 6 | k1] = x;
             kk_8[x++] = k0 << 8 | k1;
         }
     }
@@ -96,50 +135,12 @@ void chessKey::createKingKeys() {
                 continue;
             }
 
+            kkIdx_2[k0 << 6 | k1] = x;
             kk_2[x++] = k0 << 8 | k1;
         }
     }
 }
 
-void chessKey::createXXKeys() {
-    tb_xx = new int[chess_SIZE_XX];
-    tb_xxx = new int[chess_SIZE_XXX];
-    tb_xxxx = new int[chess_SIZE_XXXX];
-
-    int k0 = 0, k1 = 0, k2 = 0;
-
-    for(int i0 = 0; i0 < 64; i0++) {
-        for(int i1 = i0 + 1; i1 < 64; i1++) {
-            tb_xx[k0++] = i0 << 8 | i1;
-            for(int i2 = i1 + 1; i2 < 64; i2++) {
-                tb_xxx[k1++] = i0 << 16 | i1 << 8 | i2;
-                for(int i3 = i2 + 1; i3 < 64; i3++) {
-                    tb_xxxx[k2++] = i0 << 24 | i1 << 16 | i2 << 8 | i3;
-                }
-            }
-        }
-    }
-
-    // Pawns
-    tb_pp = new int[chess_SIZE_PP];
-    tb_ppp = new int[chess_SIZE_PPP];
-    tb_pppp = new int[chess_SIZE_PPPP];
-
-    k0 = k1 = k2 = 0;
-
-    for(int i0 = 8; i0 < 56; i0++) {
-        for(int i1 = i0 + 1; i1 < 56; i1++) {
-            tb_pp[k0++] = i0 << 8 | i1;
-            for(int i2 = i1 + 1; i2 < 56; i2++) {
-                tb_ppp[k1++] = i0 << 16 | i1 << 8 | i2;
-                for(int i3 = i2 + 1; i3 < 56; i3++) {
-                    tb_pppp[k2++] = i0 << 24 | i1 << 16 | i2 << 8 | i3;
-                }
-            }
-        }
-    }
-}
-
 int chessKey::getKey_x(int pos0)
 {
     return pos0;
@@ -147,30 +148,23 @@ int chessKey::getKey_x(int pos0)
 
 int chessKey::getKey_xx(int pos0, int pos1)
 {
-    auto p0 = MIN(pos0, pos1);
-    auto p1 = MAX(pos0, pos1);
-
-    int x = p0 << 8 | p1;
-
-    return bSearch(tb_xx, chess_SIZE_XX, x);
+    int p[2] = { pos0, pos1 };
+    SORT2(p[0], p[1]);
+    return rankCombination(p, 2, 64);
 }
 
 int chessKey::getKey_xxx(int pos0, int pos1, int pos2)
 {
     int p[3] = { pos0, pos1, pos2 };
-    sort_tbkeys(p, 3);
-
-    int x = p[0] << 16 | p[1] << 8 | p[2];
-    return bSearch(tb_xxx, chess_SIZE_XXX, x);
+    SORT2(p[0], p[1]); SORT2(p[1], p[2]); SORT2(p[0], p[1]);
+    return rankCombination(p, 3, 64);
 }
 
 int chessKey::getKey_xxxx(int pos0, int pos1, int pos2, int pos3)
 {
     int p[4] = { pos0, pos1, pos2, pos3 };
-    sort_tbkeys(p, 4);
-
-    int x = p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3];
-    return bSearch(tb_xxxx, chess_SIZE_XXXX, x);
+    SORT2(p[0], p[1]); SORT2(p[2], p[3]); SORT2(p[0], p[2]); SORT2(p[1], p[3]); SORT2(p[1], p[2]);
+    return rankCombination(p, 4, 64);
 }
 
 
@@ -182,178 +176,106 @@ int chessKey::getKey_p(int pos0)
 
 int chessKey::getKey_pp(int pos0, int pos1)
 {
-    auto p0 = MIN(pos0, pos1);
-    auto p1 = MAX(pos0, pos1);
-
-    int x = p0 << 8 | p1;
-    return bSearch(tb_pp, chess_SIZE_PP, x);
+    int p[2] = { pos0 - 8, pos1 - 8 };
+    SORT2(p[0], p[1]);
+    return rankCombination(p, 2, 48);
 }
 
 int chessKey::getKey_ppp(int pos0, int pos1, int pos2)
 {
-    int p[3] = { pos0, pos1, pos2 };
-    sort_tbkeys(p, 3);
-    int x = p[0] << 16 | p[1] << 8 | p[2];
-    return bSearch(tb_ppp, chess_SIZE_PPP, x);
+    int p[3] = { pos0 - 8, pos1 - 8, pos2 - 8 };
+    SORT2(p[0], p[1]); SORT2(p[1], p[2]); SORT2(p[0], p[1]);
+    return rankCombination(p, 3, 48);
 }
 
 int chessKey::getKey_pppp(int pos0, int pos1, int pos2, int pos3)
 {
-    int p[4] = { pos0, pos1, pos2, pos3 };
-    sort_tbkeys(p, 4);
-
-    int x = p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3];
-    return bSearch(tb_pppp, chess_SIZE_PPPP, x);
+    int p[4] = { pos0 - 8, pos1 - 8, pos2 - 8, pos3 - 8 };
+    SORT2(p[0], p[1]); SORT2(p[2], p[3]); SORT2(p[0], p[2]); SORT2(p[1], p[3]); SORT2(p[1], p[2]);
+    return rankCombination(p, 4, 48);
 }
 
-bool chessKey::setupBoard_x(chessBoardCore& board, int key, PieceType type, Side side) const
+// Put n pieces of the same type into empty slots of the piece list
+static bool setupPieces(chessBoardCore& board, const int* pos, int n, PieceType type, Side side)
 {
-    if (type == PieceType::pawn) {
-        key += 8;
-    }
-
     auto sd = static_cast<int>(side);
 
-    for(int i = 1; i < 16; i++) {
+    for(int i = 1, k = 0; i < 16; i++) {
         if (board.pieceList[sd][i].isEmpty()) {
             board.pieceList[sd][i].type = type;
             board.pieceList[sd][i].side = side;
-            board.pieceList[sd][i].idx = key;
-            return true;
+            board.pieceList[sd][i].idx = pos[k];
+            if (++k == n) {
+                return true;
+            }
         }
     }
     return false;
 }
 
-bool chessKey::setupBoard_xx(chessBoardCore& board, int key, PieceType type, Side side) const
+// Squares of k pieces from their key
+static void keyToSquares(int* pos, int k, int key, PieceType type)
 {
-    int xx;
-
     if (type != PieceType::pawn) {
-        xx = tb_xx[key];
-    } else {
-        assert(key < chess_SIZE_PP);
-        xx = tb_pp[key];
+        assert(key >= 0 && key < binomial.c[64][k]);
+        unrankCombination(pos, k, 64, key);
+        return;
     }
 
-    int pos0 = xx >> 8, pos1 = xx & 0xff;
-    auto sd = static_cast<int>(side);
-
-    for(int i = 1; i < 16; i++) {
-        if (board.pieceList[sd][i].isEmpty()) {
-            board.pieceList[sd][i].type = type;
-            board.pieceList[sd][i].side = side;
-            board.pieceList[sd][i].idx = pos0;
-
-            for(i++; i < 16; i++) {
-                if (board.pieceList[sd][i].isEmpty()) {
-                    board.pieceList[sd][i].type = type;
-                    board.pieceList[sd][i].side = side;
-                    board.pieceList[sd][i].idx = pos1;
-                    return true;
-                }
-            }
-            break;
-        }
+    assert(key >= 0 && key < binomial.c[48][k]);
+    unrankCombination(pos, k, 48, key);
+    for(int i = 0; i < k; i++) {
+        pos[i] += 8;
     }
-    return false;
 }
 
-bool chessKey::setupBoard_xxx(chessBoardCore& board, int key, PieceType type, Side side) const
+bool chessKey::setupBoard_x(chessBoardCore& board, int key, PieceType type, Side side) const
 {
-    int xx;
-    if (type != PieceType::pawn) {
-        xx = tb_xxx[key];
-    } else {
-        assert(key >= 0 && key < chess_SIZE_PPP);
-        xx = tb_ppp[key];
+    if (type == PieceType::pawn) {
+        key += 8;
     }
-    int pos0 = xx >> 16, pos1 = (xx >> 8) & 0xff, pos2 = xx & 0xff;
-    auto sd = static_cast<int>(side);
+    return setupPieces(board, &key, 1, type, side);
+}
 
-    for(int i = 1; i < 16; i++) {
-        if (board.pieceList[sd][i].isEmpty()) {
-            board.pieceList[sd][i].type = type;
-            board.pieceList[sd][i].side = side;
-            board.pieceList[sd][i].idx = pos0;
-
-            for(i++; i < 16; i++) {
-                if (board.pieceList[sd][i].isEmpty()) {
-                    board.pieceList[sd][i].type = type;
-                    board.pieceList[sd][i].side = side;
-                    board.pieceList[sd][i].idx = pos1;
-
-                    for(i++; i < 16; i++) {
-                        if (board.pieceList[sd][i].isEmpty()) {
-                            board.pieceList[sd][i].type = type;
-                            board.pieceList[sd][i].side = side;
-                            board.pieceList[sd][i].idx = pos2;
-                            return true;
-                        }
-                    }
-                    break;
-                }
-            }
-            break;
-        }
-    }
-    return false;
+bool chessKey::setupBoard_xx(chessBoardCore& board, int key, PieceType type, Side side) const
+{
+    int pos[2];
+    keyToSquares(pos, 2, key, type);
+    return setupPieces(board, pos, 2, type, side);
+}
+
+bool chessKey::setupBoard_xxx(chessBoardCore& board, int key, PieceType type, Side side) const
+{
+    int pos[3];
+    keyToSquares(pos, 3, key, type);
+    return setupPieces(board, pos, 3, type, side);
 }
 
 bool chessKey::setupBoard_xxxx(chessBoardCore& board, int key, PieceType type, Side side) const
 {
-    int xx;
-    if (type != PieceType::pawn) {
-        xx = tb_xxxx[key];
-    } else {
-        assert(key >= 0 && key < chess_SIZE_PPPP);
-        xx = tb_pppp[key];
-    }
+    int pos[4];
+    keyToSquares(pos, 4, key, type);
+    return setupPieces(board, pos, 4, type, side);
+}
 
-    int pos0 = xx >> 24, pos1 = (xx >> 16) & 0xff, pos2 = (xx >> 8) & 0xff, pos3 = xx & 0xff;
-    auto sd = static_cast<int>(side);
+// Squares after flipping and flip modes after flipping again, for specialised keys
+static int flipSquares[8][64];
+static FlipMode flipCompose[8][8];
 
-    for(int i = 1; i < 16; i++) {
-        if (board.pieceList[sd][i].isEmpty()) {
-            board.pieceList[sd][i].type = type;
-            board.pieceList[sd][i].side = side;
-            board.pieceList[sd][i].idx = pos0;
-
-            for(i++; i < 16; i++) {
-                if (board.pieceList[sd][i].isEmpty()) {
-                    board.pieceList[sd][i].type = type;
-                    board.pieceList[sd][i].side = side;
-                    board.pieceList[sd][i].idx = pos1;
-
-                    for(i++; i < 16; i++) {
-                        if (board.pieceList[sd][i].isEmpty()) {
-                            board.pieceList[sd][i].type = type;
-                            board.pieceList[sd][i].side = side;
-                            board.pieceList[sd][i].idx = pos2;
-
-                            for(i++; i < 16; i++) {
-                                if (board.pieceList[sd][i].isEmpty()) {
-                                    board.pieceList[sd][i].type = type;
-                                    board.pieceList[sd][i].side = side;
-                                    board.pieceList[sd][i].idx = pos3;
-                                    return true;
-                                }
-                            }
-                            break;
-                        }
-                    }
-                    break;
-                }
-            }
-            break;
+void chessKey::createFlipTables() {
+    for(int m = 0; m < 8; m++) {
+        for(int pos = 0; pos < 64; pos++) {
+            flipSquares[m][pos] = chessBoardCore::flip(pos, static_cast<FlipMode>(m));
+        }
+        for(int m2 = 0; m2 < 8; m2++) {
+            flipCompose[m][m2] = chessBoardCore::flip(static_cast<FlipMode>(m), static_cast<FlipMode>(m2));
         }
     }
-    return false;
 }
 
 void chessKey::initOnce() {
     createKingKeys();
-    createXXKeys();
+    createFlipTables();
 }
 
 chessKey::chessKey() {
@@ -361,6 +283,10 @@ chessKey::chessKey() {
 }
 
 void chessKey::getKey(chessKeyRec& rec, const chessBoardCore& board, const int* idxArr, const i64* idxMult, u32 order) {
+    getKey(rec, board.pieceList, idxArr, idxMult, order);
+}
+
+void chessKey::getKey(chessKeyRec& rec, const Piece (*pieceList)[16], const int* idxArr, const i64* idxMult, u32 order) {
     int sd = W;
 
     // Check which side for left hand side
@@ -368,13 +294,13 @@ void chessKey::getKey(chessKeyRec& rec, const chessBoardCore& board, const int*
     int cnt[] = { 0, 0 };
     int pawnCnt = 0;
 
-    for (int s = 0, d = 0; s < 2; s++, d = 16) {
+    for (int s = 0; s < 2; s++) {
         for(int i = 1; i < 16; i++) {
-            if (!board.pieceList[s][i].isEmpty()) {
+            if (!pieceList[s][i].isEmpty()) {
                 cnt[s]++;
-                int type = static_cast<int>(board.pieceList[s][i].type);
+                int type = static_cast<int>(pieceList[s][i].type);
                 mat[s] += exchangePieceValue[type];
-                if (board.pieceList[s][i].type == PieceType::pawn) {
+                if (pieceList[s][i].type == PieceType::pawn) {
                     pawnCnt++;
                 }
             }
@@ -413,7 +339,7 @@ void chessKey::getKey(chessKeyRec& rec, const chessBoardCore& board, const int*
         switch (attr) {
             case chess_IDX_K_8:
             {
-                auto idx = board.pieceList[sd][0].idx;
+                auto idx = pieceList[sd][0].idx;
 
                 int flip = tb_flipMode[idx];
                 flipMode = chessBoardCore::flip(flipMode, static_cast<FlipMode>(flip));
@@ -426,7 +352,7 @@ void chessKey::getKey(chessKeyRec& rec, const chessBoardCore& board, const int*
 
             case chess_IDX_K_2:
             {
-                int pos = board.pieceList[sd][0].idx;
+                int pos = pieceList[sd][0].idx;
                 pos = chessBoardCore::flip(pos, flipMode);
                 auto f = pos & 0x7;
                 if (f > 3) {
@@ -442,8 +368,8 @@ void chessKey::getKey(chessKeyRec& rec, const chessBoardCore& board, const int*
 
             case chess_IDX_KK_2:
             {
-                int pos0 = chessBoardCore::flip(board.pieceList[sd][0].idx, flipMode);
-                int pos1 = chessBoardCore::flip(board.pieceList[1 - sd][0].idx, flipMode);
+                int pos0 = chessBoardCore::flip(pieceList[sd][0].idx, flipMode);
+                int pos1 = chessBoardCore::flip(pieceList[1 - sd][0].idx, flipMode);
 
                 if (COL(pos0) > 3) {
                     flipMode = chessBoardCore::flip(flipMode, FlipMode::horizontal);
@@ -451,8 +377,7 @@ void chessKey::getKey(chessKeyRec& rec, const chessBoardCore& board, const int*
                     pos1 = chessBoardCore::flip(pos1, FlipMode::horizontal);
                 }
 
-                int kk = pos0 << 8 | pos1;
-                int idx = bSearch(kk_2, chess_SIZE_KK2, kk);
+                int idx = kkIdx_2[pos0 << 6 | pos1];
                 assert(idx >= 0 && idx < chess_SIZE_KK2);
 
                 key += idx * mul;
@@ -461,8 +386,8 @@ void chessKey::getKey(chessKeyRec& rec, const chessBoardCore& board, const int*
 
             case chess_IDX_KK_8:
             {
-                int pos0 = chessBoardCore::flip(board.pieceList[sd][0].idx, flipMode);
-                int pos1 = chessBoardCore::flip(board.pieceList[1 - sd][0].idx, flipMode);
+                int pos0 = chessBoardCore::flip(pieceList[sd][0].idx, flipMode);
+                int pos1 = chessBoardCore::flip(pieceList[1 - sd][0].idx, flipMode);
 
                 int flip = tb_flipMode[pos0];
 
@@ -473,15 +398,14 @@ void chessKey::getKey(chessKeyRec& rec, const chessBoardCore& board, const int*
                     pos1 = chessBoardCore::flip(pos1, flipMode2);
                 }
 
-                int kk = pos0 << 8 | pos1;
-                int idx = bSearch(kk_8, chess_SIZE_KK8, kk);
+                int idx = kkIdx_8[pos0 << 6 | pos1];
                 key += idx * mul;
                 break;
             }
 
             case chess_IDX_K:
             {
-                auto idx = chessBoardCore::flip(board.pieceList[sd][0].idx, flipMode);
+                auto idx = chessBoardCore::flip(pieceList[sd][0].idx, flipMode);
                 key += idx * mul;
                 break;
             }
@@ -494,7 +418,7 @@ void chessKey::getKey(chessKeyRec& rec, const chessBoardCore& board, const int*
             {
                 PieceType type = static_cast<PieceType>(attr - chess_IDX_Q + 1);
                 for(int t = 1; t < 16; t++) {
-                    auto p = board.pieceList[sd][t];
+                    auto p = pieceList[sd][t];
                     if (!p.isEmpty() && p.type == type) {
                         auto pos = chessBoardCore::flip(p.idx, flipMode);
                         assert(pos >= 0 && pos < 64);
@@ -520,11 +444,11 @@ void chessKey::getKey(chessKeyRec& rec, const chessBoardCore& board, const int*
                 PieceType type = static_cast<PieceType>(attr - chess_IDX_QQ + 1);
 
                 for(int t = 1; t < 16; t++) {
-                    auto p0 = board.pieceList[sd][t];
+                    auto p0 = pieceList[sd][t];
                     if (!p0.isEmpty() && p0.type == type) {
                         auto idx0 = chessBoardCore::flip(p0.idx, flipMode);
                         for(t++; t < 16; t++) {
-                            auto p1 = board.pieceList[sd ][t];
+                            auto p1 = pieceList[sd ][t];
                             if (!p1.isEmpty() && p1.type == type) {
                                 auto idx1 = chessBoardCore::flip(p1.idx, flipMode);
 
@@ -548,15 +472,15 @@ void chessKey::getKey(chessKeyRec& rec, const chessBoardCore& board, const int*
                 PieceType type = static_cast<PieceType>(attr - chess_IDX_QQQ + 1);
 
                 for(int t = 1; t < 16; t++) {
-                    auto p0 = board.pieceList[sd][t];
+                    auto p0 = pieceList[sd][t];
                     if (!p0.isEmpty() && p0.type == type) {
                         auto idx0 = chessBoardCore::flip(p0.idx, flipMode);
                         for(t++; t < 16; t++) {
-                            auto p1 = board.pieceList[sd][t];
+                            auto p1 = pieceList[sd][t];
                             if (!p1.isEmpty() && p1.type == type) {
                                 auto idx1 = chessBoardCore::flip(p1.idx, flipMode);
                                 for(t++; t < 16; t++) {
-                                    auto p2 = board.pieceList[sd][t];
+                                    auto p2 = pieceList[sd][t];
                                     if (!p2.isEmpty() && p2.type == type) {
                                         auto idx2 = chessBoardCore::flip(p2.idx, flipMode);
 
@@ -583,19 +507,19 @@ void chessKey::getKey(chessKeyRec& rec, const chessBoardCore& board, const int*
                 PieceType type = static_cast<PieceType>(attr - chess_IDX_QQQQ + 1);
 
                 for(int t = 1; t < 16; t++) {
-                    auto p0 = board.pieceList[sd][t];
+                    auto p0 = pieceList[sd][t];
                     if (!p0.isEmpty() && p0.type == type) {
                         auto idx0 = chessBoardCore::flip(p0.idx, flipMode);
                         for(t++; t < 16; t++) {
-                            auto p1 = board.pieceList[sd][t];
+                            auto p1 = pieceList[sd][t];
                             if (!p1.isEmpty() && p1.type == type) {
                                 auto idx1 = chessBoardCore::flip(p1.idx, flipMode);
                                 for(t++; t < 16; t++) {
-                                    auto p2 = board.pieceList[sd][t];
+                                    auto p2 = pieceList[sd][t];
                                     if (!p2.isEmpty() && p2.type == type) {
                                         auto idx2 = chessBoardCore::flip(p2.idx, flipMode);
                                         for(t++; t < 16; t++) {
-                                            auto p3 = board.pieceList[sd][t];
+                                            auto p3 = pieceList[sd][t];
                                             if (!p3.isEmpty() && p3.type == type) {
                                                 auto idx3 = chessBoardCore::flip(p3.idx, flipMode);
 
@@ -622,3 +546,385 @@ void chessKey::getKey(chessKeyRec& rec, const chessBoardCore& board, const int*
     rec.key = key;
 }
 
+
+//////////////////////////////////////////////////////////////////////
+// Specialised keys
+//////////////////////////////////////////////////////////////////////
+
+/*
+ * Attributes of an endgame name, the same ones parseAttr gives without ordering
+ */
+class chessKeyLayout {
+public:
+    int attrs[8] = {};
+    int cnt = 0;
+
+    constexpr chessKeyLayout(const char* name) {
+        bool havingPawns = false;
+        for(int i = 0; name[i]; i++) {
+            havingPawns = havingPawns || name[i] == 'p';
+        }
+
+        for(int i = 0, sd = W; name[i] && cnt < 8; i++) {
+            auto ch = name[i];
+            if (ch == 'k') {
+                if (i == 0) {
+                    attrs[cnt++] = havingPawns ? chess_IDX_KK_2 : chess_IDX_KK_8;
+                } else {
+                    sd = B;
+                }
+                continue;
+            }
+
+            int t = chess_IDX_Q + (ch == 'q' ? 0 : ch == 'r' ? 1 : ch == 'b' ? 2 : ch == 'n' ? 3 : 4);
+            for(; name[i + 1] == ch; i++) {
+                t += 5;
+            }
+            attrs[cnt++] = t | (sd << 8);
+        }
+    }
+};
+
+/*
+ * Squares of pieces by side and type
+ */
+class chessKeySquares {
+public:
+    int pos[2][6][4];
+    int cnt[2][6];
+
+    // Pieces are collected, true if black is the strong side (flipSide)
+    bool collect(const Piece (*pieceList)[16]) {
+        memset(cnt, 0, sizeof(cnt));
+        int total[2] = { 0, 0 };
+        for(int sd = 0; sd < 2; sd++) {
+            for(int i = 1; i < 16; i++) {
+                auto& p = pieceList[sd][i];
+                if (!p.isEmpty()) {
+                    auto type = static_cast<int>(p.type);
+                    assert(cnt[sd][type] < 4);
+                    pos[sd][type][cnt[sd][type]++] = p.idx;
+                    total[sd]++;
+                }
+            }
+        }
+
+        if (total[B] != total[W]) {
+            return total[B] > total[W];
+        }
+        int mat[2] = { 0, 0 };
+        for(int t = 1; t < 6; t++) {
+            mat[B] += cnt[B][t] * exchangePieceValue[t];
+            mat[W] += cnt[W][t] * exchangePieceValue[t];
+        }
+        return mat[B] > mat[W];
+    }
+};
+
+template <int K>
+static inline void sortSquares(int* p) {
+    if (K == 2) {
+        SORT2(p[0], p[1]);
+    } else if (K == 3) {
+        SORT2(p[0], p[1]); SORT2(p[1], p[2]); SORT2(p[0], p[1]);
+    } else if (K == 4) {
+        SORT2(p[0], p[1]); SORT2(p[2], p[3]); SORT2(p[0], p[2]); SORT2(p[1], p[3]); SORT2(p[1], p[2]);
+    }
+}
+
+// Key of a group of pieces (such as chess_IDX_RR of black) after flipping
+template <int Attr>
+static inline int getKeyOfGroup(const chessKeySquares& squares, int flipSide, const int* flip) {
+    constexpr int attr = Attr & 0xff, k = (attr - chess_IDX_Q) / 5 + 1, type = (attr - chess_IDX_Q) % 5 + 1;
+    constexpr bool pawn = type == static_cast<int>(PieceType::pawn);
+    static_assert(attr >= chess_IDX_Q && attr <= chess_IDX_LAST, "not a group of pieces");
+
+    auto sd = (Attr >> 8) ^ flipSide;
+    assert(squares.cnt[sd][type] == k);
+
+    int p[k];
+    for(int i = 0; i < k; i++) {
+        p[i] = flip[squares.pos[sd][type][i]] - (pawn ? 8 : 0);
+    }
+    if (k == 1) {
+        return p[0];
+    }
+    sortSquares<k>(p);
+    return rankCombination(p, k, pawn ? 48 : 64);
+}
+
+// Key of both kings, flipMode is updated with the flip which brings the strong king into its area
+template <int Attr>
+static inline int getKeyOfKings(int king0, int king1, FlipMode& flipMode) {
+    int pos0 = flipSquares[static_cast<int>(flipMode)][king0];
+    int pos1 = flipSquares[static_cast<int>(flipMode)][king1];
+
+    if (Attr == chess_IDX_KK_2) {
+        if (COL(pos0) > 3) {
+            flipMode = flipCompose[static_cast<int>(flipMode)][static_cast<int>(FlipMode::horizontal)];
+            pos0 = flipSquares[static_cast<int>(FlipMode::horizontal)][pos0];
+            pos1 = flipSquares[static_cast<int>(FlipMode::horizontal)][pos1];
+        }
+        return kkIdx_2[pos0 << 6 | pos1];
+    }
+
+    static_assert(Attr == chess_IDX_KK_2 || Attr == chess_IDX_KK_8, "not a pair of kings");
+    int flip = tb_flipMode[pos0];
+    if (flip) {
+        flipMode = flipCompose[static_cast<int>(flipMode)][flip];
+        pos0 = flipSquares[flip][pos0];
+        pos1 = flipSquares[flip][pos1];
+    }
+    return kkIdx_8[pos0 << 6 | pos1];
+}
+
+template <const char* Name, size_t... I>
+static void getKeyOfLayout(chessKeyRec& rec, const Piece (*pieceList)[16], const i64* mult, std::index_sequence<I...>) {
+    constexpr chessKeyLayout layout(Name);
+
+    chessKeySquares squares;
+    int flipSide = squares.collect(pieceList);
+    rec.flipSide = flipSide;
+
+    auto flipMode = flipSide ? FlipMode::vertical : FlipMode::none;
+    auto sd = W ^ flipSide;
+    i64 key = getKeyOfKings<layout.attrs[0]>(pieceList[sd][0].idx, pieceList[1 - sd][0].idx, flipMode) * mult[0];
+
+    auto flip = flipSquares[static_cast<int>(flipMode)];
+    ((key += getKeyOfGroup<layout.attrs[I + 1]>(squares, flipSide, flip) * mult[I + 1]), ...);
+
+    assert(key >= 0);
+    rec.key = key;
+}
+
+template <const char* Name>
+static void getKeyOfLayout(chessKeyRec& rec, const Piece (*pieceList)[16], const i64* mult) {
+    constexpr chessKeyLayout layout(Name);
+    getKeyOfLayout<Name>(rec, pieceList, mult, std::make_index_sequence<layout.cnt - 1>());
+}
+
+// Endgames having specialised code, others use the generic one
+#define chess_KEY_LAYOUTS(X) \
+    X(kqk) X(krk) X(kbk) X(knk) X(kpk) \
+    X(kqqk) X(kqrk) X(kqbk) X(kqnk) X(kqpk) X(krrk) X(krbk) X(krnk) X(krpk) \
+    X(kbbk) X(kbnk) X(kbpk) X(knnk) X(knpk) X(kppk) \
+    X(kqkq) X(kqkr) X(kqkb) X(kqkn) X(kqkp) X(krkr) X(krkb) X(krkn) X(krkp) \
+    X(kbkb) X(kbkn) X(kbkp) X(knkn) X(knkp) X(kpkp) \
+    X(kqqkq) X(kqrkq) X(kqpkq) X(krrkr) X(krbkr) X(krnkr) X(krpkr) X(krpkb) \
+    X(kbpkb) X(kbpkn) X(knpkn) X(kppkp)
+
+#define chess_KEY_LAYOUT_NAME(name) static constexpr char layout_##name[] = #name;
+chess_KEY_LAYOUTS(chess_KEY_LAYOUT_NAME)
+
+chessKeyEncoder chessKey::findEncoder(const std::string& name) {
+    #define chess_KEY_LAYOUT_ENTRY(name) { layout_##name, &getKeyOfLayout<layout_##name> },
+    static const std::map<std::string, chessKeyEncoder> encoders = {
+        chess_KEY_LAYOUTS(chess_KEY_LAYOUT_ENTRY)
+    };
+    #undef chess_KEY_LAYOUT_ENTRY
+
+    auto it = encoders.find(name);
+    return it != encoders.end() ? it->second : nullptr;
+}
+
+//////////////////////////////////////////////////////////////////////
+// Batch keys
+//////////////////////////////////////////////////////////////////////
+
+bool chessKeyBatch::setup(const std::string& name) {
+    clear();
+
+    chessKeyLayout layout(name.c_str());
+    attrCnt = layout.cnt;
+    pieceCnt = 2;
+    for(int a = 1; a < attrCnt; a++) {
+        attrs[a] = layout.attrs[a];
+        pieceCnt += ((attrs[a] & 0xff) - chess_IDX_Q) / 5 + 1;
+    }
+    attrs[0] = layout.attrs[0];
+
+    if (pieceCnt != (int)name.size() || pieceCnt > chess_KEY_BATCH_MAX_PIECES) {
+        attrCnt = pieceCnt = 0;
+        return false;
+    }
+    return true;
+}
+
+void chessKeyBatch::clear() {
+    for(auto && row : squares) {
+        row.clear();
+    }
+    flipSides.clear();
+}
+
+void chessKeyBatch::add(const Piece (*pieceList)[16]) {
+    chessKeySquares pieceSquares;
+    int flipSide = pieceSquares.collect(pieceList);
+    auto sd = W ^ flipSide;
+
+    squares[0].push_back(pieceList[sd][0].idx);
+    squares[1].push_back(pieceList[1 - sd][0].idx);
+    for(int a = 1, r = 2; a < attrCnt; a++) {
+        auto attr = attrs[a] & 0xff, k = (attr - chess_IDX_Q) / 5 + 1, type = (attr - chess_IDX_Q) % 5 + 1;
+        auto groupSd = (attrs[a] >> 8) ^ flipSide;
+        assert(pieceSquares.cnt[groupSd][type] == k);
+        for(int i = 0; i < k; i++) {
+            squares[r++].push_back(pieceSquares.pos[groupSd][type][i]);
+        }
+    }
+    flipSides.push_back(flipSide);
+}
+
+static i64 getBatchKey(const chessKeyBatch& batch, const i64* mult, int b) {
+    auto flipMode = batch.flipSides[b] ? FlipMode::vertical : FlipMode::none;
+    auto king0 = batch.squares[0][b], king1 = batch.squares[1][b];
+    i64 key = (batch.attrs[0] & 0xff) == chess_IDX_KK_2
+        ? getKeyOfKings<chess_IDX_KK_2>(king0, king1, flipMode) * mult[0]
+        : getKeyOfKings<chess_IDX_KK_8>(king0, king1, flipMode) * mult[0];
+
+    auto flip = flipSquares[static_cast<int>(flipMode)];
+    for(int a = 1, r = 2; a < batch.attrCnt; a++) {
+        auto attr = batch.attrs[a] & 0xff, k = (attr - chess_IDX_Q) / 5 + 1;
+        auto pawn = (attr - chess_IDX_Q) % 5 + 1 == static_cast<int>(PieceType::pawn);
+
+        int p[4];
+        for(int i = 0; i < k; i++, r++) {
+            p[i] = flip[batch.squares[r][b]] - (pawn ? 8 : 0);
+        }
+        switch (k) {
+            case 1: key += p[0] * mult[a]; continue;
+            case 2: sortSquares<2>(p); break;
+            case 3: sortSquares<3>(p); break;
+            default: sortSquares<4>(p); break;
+        }
+        key += rankCombination(p, k, pawn ? 48 : 64) * mult[a];
+    }
+
+    assert(key >= 0);
+    return key;
+}
+
+#ifdef chess_KEY_AVX2
+
+#define chess_AVX2 __attribute__((target("avx2")))
+
+// 16-bit entries of a table (padded by one entry) by 32-bit gathers
+chess_AVX2 static inline __m256i gatherI16(const i16* table, __m256i idx) {
+    auto v = _mm256_i32gather_epi32((const int*)table, idx, 2);
+    return _mm256_srai_epi32(_mm256_slli_epi32(v, 16), 16);
+}
+
+chess_AVX2 static inline __m256i gatherI32(const int* table, __m256i idx) {
+    return _mm256_i32gather_epi32(table, idx, 4);
+}
+
+chess_AVX2 static inline void sort2(__m256i& a, __m256i& b) {
+    auto t = _mm256_min_epi32(a, b);
+    b = _mm256_max_epi32(a, b);
+    a = t;
+}
+
+// Keys of 8 boards from b, the same steps of getBatchKey on lanes
+chess_AVX2 static void getBatchKeys8(const chessKeyBatch& batch, const i64* mult, int b, i64* keys) {
+    auto flipTable = (const int*)flipSquares, composeTable = (const int*)flipCompose;
+    auto binomialTable = (const int*)binomial.c;
+
+    auto flipSide = _mm256_loadu_si256((const __m256i*)(batch.flipSides.data() + b));
+    auto flipMode = _mm256_mullo_epi32(flipSide, _mm256_set1_epi32(static_cast<int>(FlipMode::vertical)));
+
+    auto king0 = _mm256_loadu_si256((const __m256i*)(batch.squares[0].data() + b));
+    auto king1 = _mm256_loadu_si256((const __m256i*)(batch.squares[1].data() + b));
+    auto pos0 = gatherI32(flipTable, _mm256_add_epi32(_mm256_slli_epi32(flipMode, 6), king0));
+    auto pos1 = gatherI32(flipTable, _mm256_add_epi32(_mm256_slli_epi32(flipMode, 6), king1));
+
+    __m256i kk;
+    if ((batch.attrs[0] & 0xff) == chess_IDX_KK_2) {
+        auto mirror = _mm256_cmpgt_epi32(_mm256_and_si256(pos0, _mm256_set1_epi32(7)), _mm256_set1_epi32(3));
+        auto mirrorMode = gatherI32(composeTable, _mm256_add_epi32(_mm256_slli_epi32(flipMode, 3), _mm256_set1_epi32(static_cast<int>(FlipMode::horizontal))));
+        flipMode = _mm256_blendv_epi8(flipMode, mirrorMode, mirror);
+        pos0 = _mm256_xor_si256(pos0, _mm256_and_si256(mirror, _mm256_set1_epi32(7)));
+        pos1 = _mm256_xor_si256(pos1, _mm256_and_si256(mirror, _mm256_set1_epi32(7)));
+        kk = gatherI16(kkIdx_2, _mm256_or_si256(_mm256_slli_epi32(pos0, 6), pos1));
+    } else {
+        auto flip = gatherI32(tb_flipMode, pos0);
+        flipMode = gatherI32(composeTable, _mm256_add_epi32(_mm256_slli_epi32(flipMode, 3), flip));
+        pos0 = gatherI32(flipTable, _mm256_add_epi32(_mm256_slli_epi32(flip, 6), pos0));
+        pos1 = gatherI32(flipTable, _mm256_add_epi32(_mm256_slli_epi32(flip, 6), pos1));
+        kk = gatherI16(kkIdx_8, _mm256_or_si256(_mm256_slli_epi32(pos0, 6), pos1));
+    }
+
+    // Sub keys and multipliers are below 2^32, products are summed in 64-bit lanes
+    auto m = _mm256_set1_epi64x(mult[0]);
+    auto keyLo = _mm256_mul_epu32(_mm256_cvtepu32_epi64(_mm256_castsi256_si128(kk)), m);
+    auto keyHi = _mm256_mul_epu32(_mm256_cvtepu32_epi64(_mm256_extracti128_si256(kk, 1)), m);
+
+    auto flipBase = _mm256_slli_epi32(flipMode, 6);
+    for(int a = 1, r = 2; a < batch.attrCnt; a++) {
+        auto attr = batch.attrs[a] & 0xff, k = (attr - chess_IDX_Q) / 5 + 1;
+        auto pawn = (attr - chess_IDX_Q) % 5 + 1 == static_cast<int>(PieceType::pawn);
+        auto n = pawn ? 48 : 64;
+
+        __m256i p[4];
+        for(int i = 0; i < k; i++, r++) {
+            auto sq = _mm256_loadu_si256((const __m256i*)(batch.squares[r].data() + b));
+            p[i] = _mm256_sub_epi32(gatherI32(flipTable, _mm256_add_epi32(flipBase, sq)), _mm256_set1_epi32(pawn ? 8 : 0));
+        }
+
+        __m256i subKey;
+        if (k == 1) {
+            subKey = p[0];
+        } else {
+            if (k == 2) {
+                sort2(p[0], p[1]);
+            } else if (k == 3) {
+                sort2(p[0], p[1]); sort2(p[1], p[2]); sort2(p[0], p[1]);
+            } else {
+                sort2(p[0], p[1]); sort2(p[2], p[3]); sort2(p[0], p[2]); sort2(p[1], p[3]); sort2(p[1], p[2]);
+            }
+
+            // rankCombination: C(n, k) - 1 - sum of C(n - 1 - p[i], k - i)
+            subKey = _mm256_set1_epi32(binomial.c[n][k] - 1);
+            for(int i = 0; i < k; i++) {
+                auto idx = _mm256_add_epi32(_mm256_mullo_epi32(_mm256_sub_epi32(_mm256_set1_epi32(n - 1), p[i]), _mm256_set1_epi32(5)), _mm256_set1_epi32(k - i));
+                subKey = _mm256_sub_epi32(subKey, gatherI32(binomialTable, idx));
+            }
+        }
+
+        m = _mm256_set1_epi64x(mult[a]);
+        keyLo = _mm256_add_epi64(keyLo, _mm256_mul_epu32(_mm256_cvtepu32_epi64(_mm256_castsi256_si128(subKey)), m));
+        keyHi = _mm256_add_epi64(keyHi, _mm256_mul_epu32(_mm256_cvtepu32_epi64(_mm256_extracti128_si256(subKey, 1)), m));
+    }
+
+    _mm256_storeu_si256((__m256i*)(keys + b), keyLo);
+    _mm256_storeu_si256((__m256i*)(keys + b + 4), keyHi);
+}
+
+#endif // chess_KEY_AVX2
+
+bool chessKey::hasSimd() {
+#ifdef chess_KEY_AVX2
+    static const bool avx2 = __builtin_cpu_supports("avx2");
+    return avx2;
+#else
+    return false;
+#endif
+}
+
+void chessKey::getKeys(const chessKeyBatch& batch, const i64* mult, i64* keys, bool simd) {
+    int b = 0, cnt = batch.size();
+
+#ifdef chess_KEY_AVX2
+    for(int a = 0; a < batch.attrCnt; a++) {
+        simd = simd && mult[a] >= 0 && mult[a] <= 0xffffffffLL;
+    }
+    if (simd && hasSimd()) {
+        for(; b + 8 <= cnt; b += 8) {
+            getBatchKeys8(batch, mult, b, keys);
+        }
+    }
+#endif
+
+    for(; b < cnt; b++) {
+        keys[b] = getBatchKey(batch, mult, b);
+    }
+}
@@ -2,6 +2,8 @@
 #define chessKey_h
 
 #include <map>
+#include <string>
+#include <vector>
 
 #include "chess.h"
 
@@ -13,12 +15,44 @@ namespace chess {
         bool flipSide;
     };
 
+#define chess_KEY_BATCH_MAX_PIECES  8
+
+    /*
+     * Squares of pieces of many boards of one endgame as a structure of arrays, for batch keys.
+     * Row i keeps the i-th piece in name order of all boards (kings of the strong and the weak sides
+     * first, then pieces of groups), squares are not flipped yet
+     */
+    class chessKeyBatch {
+    public:
+        int     attrs[8], attrCnt = 0, pieceCnt = 0;
+        std::vector<int> squares[chess_KEY_BATCH_MAX_PIECES];
+        std::vector<int> flipSides;
+
+        // Layout of the endgame, boards are removed
+        bool    setup(const std::string& name);
+        void    clear();
+
+        void    add(const Piece (*pieceList)[16]);
+        int     size() const { return (int)flipSides.size(); }
+    };
+
     class chessKey {
     public:
         chessKey();
 
+        // Keys depend on piece lists only, any type of board could use the same code
+        static void getKey(chessKeyRec& rec, const Piece (*pieceList)[16], const int* idxArr, const i64* idxMult, u32 order);
         static void getKey(chessKeyRec& rec, const chessBoardCore& board, const int* idxArr, const i64* idxMult, u32 order);
 
+        // Same keys as getKey by code specialised for the layout of the endgame (pieces in name order,
+        // mult: multipliers in that order), nullptr if the endgame has no specialised code
+        static chessKeyEncoder findEncoder(const std::string& name);
+
+        // Keys of all boards of the batch (mult: multipliers in name order), 8 boards at once with AVX2
+        // if the CPU has it and simd is true
+        static void getKeys(const chessKeyBatch& batch, const i64* mult, i64* keys, bool simd = true);
+        static bool hasSimd();
+
         bool setupBoard_x(chessBoardCore& board, int key, PieceType type, Side side) const;
         bool setupBoard_xx(chessBoardCore& board, int key, PieceType type, Side side) const;
         bool setupBoard_xxx(chessBoardCore& board, int key, PieceType type, Side side) const;
@@ -37,7 +71,8 @@ namespace chess {
 
         void initOnce();
 
-        void createXXKeys();
+        void createFlipTables();
+
         void createKingKeys();
 
     private:
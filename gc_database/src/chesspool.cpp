@@ -0,0 +1,69 @@
+#include "chess.h"
+#include "chesspool.h"
+
+using namespace chess;
+
+chessThreadPool::chessThreadPool(int threadCnt) {
+    busyCnt = 0;
+    stopping = false;
+
+    if (threadCnt <= 0) {
+        threadCnt = MAX(1, (int)std::thread::hardware_concurrency());
+    }
+    for(int i = 0; i < threadCnt; i++) {
+        workers.emplace_back(&chessThreadPool::run, this);
+    }
+}
+
+chessThreadPool::~chessThreadPool() {
+    {
+        std::lock_guard<std::mutex> thelock(mtx);
+        stopping = true;
+    }
+    taskCv.notify_all();
+
+    // Workers finish all queued tasks before leaving
+    for(auto && worker : workers) {
+        worker.join();
+    }
+}
+
+std::future<void> chessThreadPool::submit(std::function<void()> task) {
+    std::packaged_task<void()> packagedTask(std::move(task));
+    auto future = packagedTask.get_future();
+    {
+        std::lock_guard<std::mutex> thelock(mtx);
+        tasks.push(std::move(packagedTask));
+    }
+    taskCv.notify_one();
+    return future;
+}
+
+void chessThreadPool::wait() {
+    std::unique_lock<std::mutex> thelock(mtx);
+    doneCv.wait(thelock, [this] { return tasks.empty() && busyCnt == 0; });
+}
+
+void chessThreadPool::run() {
+    for(;;) {
+        std::packaged_task<void()> task;
+        {
+            std::unique_lock<std::mutex> thelock(mtx);
+            taskCv.wait(thelock, [this] { return stopping || !tasks.empty(); });
+            if (tasks.empty()) {
+                return;
+            }
+            task = std::move(tasks.front());
+            tasks.pop();
+            busyCnt++;
+        }
+
+        task();
+
+        {
+            std::lock_guard<std::mutex> thelock(mtx);
+            busyCnt--;
+        }
+        doneCv.notify_all();
+    }
+}
@@ -0,0 +1,46 @@
+#ifndef chessPool_h
+#define chessPool_h
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "chess.h"
+
+namespace chess {
+
+    /*
+     * Fixed number of worker threads running tasks in the order they are submitted
+     */
+    class chessThreadPool {
+    public:
+        // threadCnt 0: number of cores
+        chessThreadPool(int threadCnt = 0);
+        ~chessThreadPool();
+
+        int     getThreadCnt() const { return (int)workers.size(); }
+
+        std::future<void> submit(std::function<void()> task);
+
+        // Wait until all submitted tasks are done
+        void    wait();
+
+    private:
+        std::vector<std::thread> workers;
+        std::queue<std::packaged_task<void()>> tasks;
+
+        std::mutex  mtx;
+        std::condition_variable taskCv, doneCv;
+        int         busyCnt;
+        bool        stopping;
+
+        void    run();
+    };
+
+} // namespace chess
+
+#endif /* chessPool_h */
@@ -0,0 +1,63 @@
+#include <vector>
+
+#include "chess.h"
+#include "chessstats.h"
+
+using namespace chess;
+
+namespace {
+
+    // Counters of living threads and sums of ended ones. Never destroyed, threads may end after static objects
+    class chessCounterRegistry {
+    public:
+        std::mutex  mtx;
+        std::vector<chessThreadCounters*> threads;
+        u64         endedCounts[counter_count] = { 0 };
+
+        static chessCounterRegistry& get() {
+            static auto registry = new chessCounterRegistry();
+            return *registry;
+        }
+    };
+
+} // namespace
+
+chessThreadCounters::chessThreadCounters() {
+    for (auto && counter : counters) {
+        counter = 0;
+    }
+
+    auto& registry = chessCounterRegistry::get();
+    std::lock_guard<std::mutex> thelock(registry.mtx);
+    registry.threads.push_back(this);
+}
+
+chessThreadCounters::~chessThreadCounters() {
+    auto& registry = chessCounterRegistry::get();
+    std::lock_guard<std::mutex> thelock(registry.mtx);
+    for (int i = 0; i < counter_count; i++) {
+        registry.endedCounts[i] += counters[i].load(std::memory_order_relaxed);
+    }
+    registry.threads.erase(std::remove(registry.threads.begin(), registry.threads.end(), this), registry.threads.end());
+}
+
+chessStats chessThreadCounters::getStats() {
+    u64 counts[counter_count];
+
+    auto& registry = chessCounterRegistry::get();
+    {
+        std::lock_guard<std::mutex> thelock(registry.mtx);
+        for (int i = 0; i < counter_count; i++) {
+            counts[i] = registry.endedCounts[i];
+            for (auto && threadCounters : registry.threads) {
+                counts[i] += threadCounters->counters[i].load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    chessStats stats;
+#define chess_COUNTER_GET(name) stats.name = counts[counter_##name];
+    chess_STATS_COUNTERS(chess_COUNTER_GET)
+#undef chess_COUNTER_GET
+    return stats;
+}
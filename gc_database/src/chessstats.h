@@ -0,0 +1,129 @@
+#ifndef chessStats_h
+#define chessStats_h
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <sstream>
+#include <string>
+
+#include "chess.h"
+
+namespace chess {
+
+    // Name of each counter of chessStats
+#define chess_STATS_COUNTERS(X) \
+    X(probes)               /* chessDb::getScore, boards of getScoreBatch */ \
+    X(blockCacheHits)       \
+    X(blockCacheMisses)     \
+    X(bytesRead)            /* from files, not counting mapped ones */ \
+    X(bytesDecompressed)    \
+    X(decompressNs)         \
+    X(fileOpens)            \
+    X(lockWaits)            /* mtx / sdmtx of files found locked */ \
+    X(lockWaitNs)           \
+    X(onePlyEnpassant)      /* one-ply searches instead of reading a file */ \
+    X(onePlyMissingSide)
+
+    enum chessCounter {
+#define chess_COUNTER_ENUM(name) counter_##name,
+        chess_STATS_COUNTERS(chess_COUNTER_ENUM)
+#undef chess_COUNTER_ENUM
+        counter_count
+    };
+
+    class chessStats {
+    public:
+#define chess_COUNTER_FIELD(name) u64 name = 0;
+        chess_STATS_COUNTERS(chess_COUNTER_FIELD)
+#undef chess_COUNTER_FIELD
+
+        // Counts of an interval: stats() at its end - stats() at its start
+        chessStats operator - (const chessStats& other) const {
+            chessStats r;
+#define chess_COUNTER_SUB(name) r.name = name - other.name;
+            chess_STATS_COUNTERS(chess_COUNTER_SUB)
+#undef chess_COUNTER_SUB
+            return r;
+        }
+
+        std::string toString() const {
+            std::ostringstream stringStream;
+            const char* sep = "";
+#define chess_COUNTER_PRINT(name) stringStream << sep << #name ": " << name; sep = ", ";
+            chess_STATS_COUNTERS(chess_COUNTER_PRINT)
+#undef chess_COUNTER_PRINT
+            return stringStream.str();
+        }
+    };
+
+    /*
+     * Counters of a thread. Only the thread writes them (relaxed loads and stores, no locked
+     * instructions), getStats sums all threads. Counts of ended threads are kept
+     */
+    class chessThreadCounters {
+    public:
+        chessThreadCounters();
+        ~chessThreadCounters();
+
+        void add(int counter, u64 n) {
+            counters[counter].store(counters[counter].load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        }
+
+        static chessThreadCounters& get() {
+            static thread_local chessThreadCounters threadCounters;
+            return threadCounters;
+        }
+
+        // All threads of the process, zeros if chess_STATS is 0
+        static chessStats getStats();
+
+    private:
+        std::atomic<u64> counters[counter_count];
+    };
+
+#if chess_STATS
+
+#define chess_STATS_ADD(counter, n)             chess::chessThreadCounters::get().add(chess::counter_##counter, n)
+#define chess_STATS_TIMER(timer)                auto timer = std::chrono::steady_clock::now()
+#define chess_STATS_ADD_TIME(counter, timer)    chess_STATS_ADD(counter, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - timer).count())
+
+#else
+
+#define chess_STATS_ADD(counter, n)
+#define chess_STATS_TIMER(timer)
+#define chess_STATS_ADD_TIME(counter, timer)
+
+#endif
+
+    // lock_guard counting waits, a free mutex costs one try_lock only
+    class chessLockGuard {
+    public:
+        explicit chessLockGuard(std::mutex& _mtx) : mtx(_mtx) {
+#if chess_STATS
+            if (mtx.try_lock()) {
+                return;
+            }
+            chess_STATS_TIMER(startTime);
+            mtx.lock();
+            chess_STATS_ADD(lockWaits, 1);
+            chess_STATS_ADD_TIME(lockWaitNs, startTime);
+#else
+            mtx.lock();
+#endif
+        }
+
+        ~chessLockGuard() {
+            mtx.unlock();
+        }
+
+        chessLockGuard(const chessLockGuard&) = delete;
+        chessLockGuard& operator = (const chessLockGuard&) = delete;
+
+    private:
+        std::mutex& mtx;
+    };
+
+} // namespace chess
+
+#endif /* chessStats_h */
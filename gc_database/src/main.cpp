@@ -34,6 +34,8 @@ int main() {
     chessDb.addFolders(chessDataFolder);
 
     // Data can be loaded all into memory or tiny or smart (let programm decide between all-tiny)
+    // or mapped (files are mapped into memory, no file reading when probing)
+    // or compressed (compressed data is loaded into memory, blocks are decompressed when probing)
     chess::chessMemMode chessMemMode = chess::chessMemMode::all;
     // Data can be loaded right now or don't load anything until the first request
     chess::chessLoadMode loadMode = chess::chessLoadMode::onrequest;
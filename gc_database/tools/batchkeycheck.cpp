@@ -0,0 +1,131 @@
+#include <iostream>
+#include <chrono>
+#include <iomanip>
+#include <vector>
+
+#include "chess.h"
+
+using namespace chess;
+
+/*
+ * Check of batch keys (chessKey::getKeys, AVX2 and scalar code) against the scalar encoder (chessKey::getKey)
+ *
+ * Usage: batchkeycheck [folder]
+ *
+ * All indexes of all endgames of the folder are set up, each position is checked as it is and
+ * with colours swapped (the strong side is black). Filling batches (scalar) is timed apart from keys
+ */
+
+#define CHUNK_SIZE  4096
+
+class Counter {
+public:
+    i64 keyCnt = 0, errors = 0;
+    double scalarTime = 0, fillTime = 0, batchTime = 0, simdTime = 0;
+};
+
+static double elapsedSince(std::chrono::steady_clock::time_point startTime) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+static void checkChunk(const chessFile& file, std::vector<chessProbeBoard>& boards, chessKeyBatch& batch, Counter& counter) {
+    std::vector<chessKeyRec> recs(boards.size());
+    auto startTime = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < boards.size(); i++) {
+        chessKey::getKey(recs[i], boards[i], file.idxArr, file.idxMult, file.header ? file.header->order : 0);
+    }
+    counter.scalarTime += elapsedSince(startTime);
+
+    startTime = std::chrono::steady_clock::now();
+    batch.clear();
+    for (auto && board : boards) {
+        batch.add(board.pieceList);
+    }
+    counter.fillTime += elapsedSince(startTime);
+
+    std::vector<i64> keys(boards.size()), simdKeys(boards.size());
+    startTime = std::chrono::steady_clock::now();
+    chessKey::getKeys(batch, file.keyMult, keys.data(), false);
+    counter.batchTime += elapsedSince(startTime);
+
+    startTime = std::chrono::steady_clock::now();
+    chessKey::getKeys(batch, file.keyMult, simdKeys.data(), true);
+    counter.simdTime += elapsedSince(startTime);
+
+    for (size_t i = 0; i < boards.size(); i++) {
+        if (keys[i] != recs[i].key || simdKeys[i] != recs[i].key || batch.flipSides[i] != (int)recs[i].flipSide) {
+            if (counter.errors < 20) {
+                std::cerr << "Error: " << file.getName() << ", " << boards[i].getFen() << ", key " << recs[i].key
+                          << ", batch " << keys[i] << ", simd " << simdKeys[i] << std::endl;
+            }
+            counter.errors++;
+        }
+    }
+    counter.keyCnt += boards.size();
+    boards.clear();
+}
+
+// Colours swapped and ranks mirrored, the key must be the same
+static void swapColors(chessProbeBoard& board) {
+    Piece pieceList[2][16];
+    for (int sd = 0; sd < 2; sd++) {
+        for (int i = 0; i < 16; i++) {
+            auto p = board.pieceList[1 - sd][i];
+            if (!p.isEmpty()) {
+                p.side = static_cast<Side>(sd);
+                p.idx = chessBoardCore::flip(p.idx, FlipMode::vertical);
+            }
+            pieceList[sd][i] = p;
+        }
+    }
+    memcpy(board.pieceList, pieceList, sizeof(pieceList));
+}
+
+int main(int argc, const char* argv[]) {
+    std::string folder = argc > 1 ? argv[1] : "./databases/3";
+
+    chessDb db;
+    db.addFolders(folder);
+    db.preload(chessMemMode::tiny, chessLoadMode::onrequest);
+
+    std::cout << "AVX2: " << (chessKey::hasSimd() ? "yes" : "no") << std::endl;
+    std::cout << std::left << std::setw(10) << "endgame" << std::right << std::setw(10) << "keys"
+              << std::setw(14) << "scalar M/s" << std::setw(12) << "fill M/s" << std::setw(14) << "batch M/s" << std::setw(14) << "simd M/s"
+              << std::setw(8) << "errors" << std::endl;
+
+    i64 errCnt = 0;
+    for (auto && pchessFile : db.chessFileVec) {
+        pchessFile->checkToLoadHeaderAndTable();
+        chessKeyBatch batch;
+        if (pchessFile->loadStatus != chessLoadStatus::loaded || !batch.setup(pchessFile->getName())) {
+            continue;
+        }
+
+        Counter counter;
+        std::vector<chessProbeBoard> boards;
+        chessProbeBoard board;
+        for (i64 idx = 0; idx < pchessFile->getSize(); idx++) {
+            if (!pchessFile->setupBoard(board, idx, FlipMode::none, Side::white)) {
+                continue;
+            }
+            boards.push_back(board);
+            swapColors(board);
+            boards.push_back(board);
+
+            if (boards.size() >= CHUNK_SIZE) {
+                checkChunk(*pchessFile, boards, batch, counter);
+            }
+        }
+        checkChunk(*pchessFile, boards, batch, counter);
+
+        auto n = counter.keyCnt / 1e6;
+        std::cout << std::left << std::setw(10) << pchessFile->getName() << std::right << std::setw(10) << counter.keyCnt
+                  << std::fixed << std::setprecision(1) << std::setw(14) << n / counter.scalarTime
+                  << std::setw(12) << n / counter.fillTime << std::setw(14) << n / counter.batchTime << std::setw(14) << n / counter.simdTime
+                  << std::setw(8) << counter.errors << std::endl;
+        errCnt += counter.errors;
+    }
+
+    std::cout << (errCnt ? "failed" : "passed") << std::endl;
+    return errCnt ? 1 : 0;
+}
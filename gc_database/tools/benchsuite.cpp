@@ -0,0 +1,318 @@
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <iomanip>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "chess.h"
+
+using namespace chess;
+
+/*
+ * Probe benchmark suite, results are written as JSON to be compared between releases
+ *
+ * Usage: benchsuite [options]
+ *   -d folder          endgames (default ./chess)
+ *   -fen file          positions from a file, one FEN a line (default: random indexes of all endgames)
+ *   -m modes           memory modes, comma separated (default tiny,all,smart)
+ *   -t threads         thread counts, comma separated (default 1,2,4... up to the number of cores)
+ *   -n probes          getScore calls per thread in the warm phase (default 1000000)
+ *   -np probes         probe calls per thread in the warm phase (default 20000)
+ *   -p positions       random positions (default 16384)
+ *   -o file            JSON output (default benchsuite.json, - for stdout)
+ *
+ * Each run (operation, memory mode, threads) starts with a new chessDb loading files on request, all caches
+ * are empty. The cold phase probes each position once, the positions are split among threads, loading is
+ * timed as part of probes. The warm phase then probes the positions again and again. Every call is timed
+ * for the p50/p99 latencies, the throughput is the number of calls of all threads by the wall time.
+ * Counters of chessDb::stats() are given for each run
+ */
+
+class Options {
+public:
+    std::string folder = "./chess", fenPath, outPath = "benchsuite.json";
+    std::vector<std::string> memModes { "tiny", "all", "smart" };
+    std::vector<int> threadCnts;
+    i64 scoreCnt = 1000000, probeCnt = 20000;
+    int positionCnt = 1 << 14;
+};
+
+class RunResult {
+public:
+    std::string op, memMode, phase;
+    int threadCnt;
+    i64 calls;
+    double seconds, p50, p99;   // latencies in nanoseconds
+    u64 checksum;
+    chessStats stats;           // counters of the run
+};
+
+static std::vector<std::string> split(const std::string& str) {
+    std::vector<std::string> vec;
+    std::istringstream stream(str);
+    for (std::string s; std::getline(stream, s, ',');) {
+        if (!s.empty()) {
+            vec.push_back(s);
+        }
+    }
+    return vec;
+}
+
+static bool isProbable(chessDb& db, chessProbeBoard& board) {
+    if (!board.isLegal()) {
+        return false;
+    }
+    auto pchessFile = db.getchessFile(board);
+    if (pchessFile == nullptr) {
+        return false;
+    }
+    pchessFile->checkToLoadHeaderAndTable();
+    return pchessFile->loadStatus == chessLoadStatus::loaded;
+}
+
+static std::vector<chessProbeBoard> createBoards(chessDb& db, int cnt, u64 seed) {
+    std::vector<chessProbeBoard> boards;
+    std::mt19937_64 rng(seed);
+
+    for (int tried = 0; (int)boards.size() < cnt && tried < cnt * 100; tried++) {
+        auto pchessFile = db.chessFileVec[rng() % db.chessFileVec.size()];
+        pchessFile->checkToLoadHeaderAndTable();
+        if (pchessFile->loadStatus != chessLoadStatus::loaded) {
+            continue;
+        }
+
+        chessProbeBoard board;
+        auto idx = (i64)(rng() % (u64)pchessFile->getSize());
+        if (!pchessFile->setupBoard(board, idx, FlipMode::none, Side::white)) {
+            continue;
+        }
+
+        board.side = rng() & 1 ? Side::white : Side::black;
+        if (isProbable(db, board)) {
+            boards.push_back(board);
+        }
+    }
+    return boards;
+}
+
+static std::vector<chessProbeBoard> readBoards(chessDb& db, const std::string& path) {
+    std::vector<chessProbeBoard> boards;
+    std::ifstream file(path);
+    for (std::string line; std::getline(file, line);) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        chessProbeBoard board;
+        board.setFen(line);
+        if (isProbable(db, board)) {
+            boards.push_back(board);
+        }
+    }
+    return boards;
+}
+
+static double percentile(std::vector<u32>& latencies, double p) {
+    if (latencies.empty()) {
+        return 0;
+    }
+    auto k = MIN(latencies.size() - 1, (size_t)(latencies.size() * p));
+    std::nth_element(latencies.begin(), latencies.begin() + k, latencies.end());
+    return latencies[k];
+}
+
+// Thread t calls the operation on positions t, t + step, t + 2 * step... cnt times
+static RunResult runPhase(chessDb& db, const std::vector<chessProbeBoard>& boards, bool useProbe,
+                          int threadCnt, i64 cnt, int step) {
+    std::vector<std::thread> threads;
+    std::vector<std::vector<u32>> latencies(threadCnt);
+    std::vector<u64> checksums(threadCnt);
+
+    auto startStats = db.stats();
+    auto startTime = std::chrono::steady_clock::now();
+    for (int t = 0; t < threadCnt; t++) {
+        threads.emplace_back([&, t]() {
+            auto myBoards = boards; // getScore and probe make/take back moves on boards
+            auto& myLatencies = latencies[t];
+            myLatencies.reserve(cnt);
+            MoveList moveList;
+            u64 checksum = 0;
+
+            for (i64 i = 0, j = t; i < cnt; i++, j += step) {
+                auto& board = myBoards[j % myBoards.size()];
+                auto callTime = std::chrono::steady_clock::now();
+                int score;
+                if (useProbe) {
+                    moveList.reset();
+                    score = db.probe(board, moveList);
+                } else {
+                    score = db.getScore(board);
+                }
+                myLatencies.push_back((u32)MIN((i64)0xffffffff, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - callTime).count()));
+                checksum = checksum * 31 + (u64)score;
+            }
+            checksums[t] = checksum;
+        });
+    }
+    for (auto && thread : threads) {
+        thread.join();
+    }
+
+    RunResult result;
+    result.threadCnt = threadCnt;
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    result.stats = db.stats() - startStats;
+
+    std::vector<u32> all;
+    for (auto && vec : latencies) {
+        all.insert(all.end(), vec.begin(), vec.end());
+    }
+    result.calls = (i64)all.size();
+    result.p50 = percentile(all, 0.5);
+    result.p99 = percentile(all, 0.99);
+
+    result.checksum = 0;
+    for (auto && checksum : checksums) {
+        result.checksum ^= checksum;
+    }
+    return result;
+}
+
+static std::string jsonString(const std::string& str) {
+    std::string s = "\"";
+    for (auto ch : str) {
+        if (ch == '"' || ch == '\\') {
+            s += '\\';
+        }
+        s += ch;
+    }
+    return s + "\"";
+}
+
+static std::string toJson(const Options& options, const std::string& source, size_t positionCnt, const std::vector<RunResult>& results) {
+    std::ostringstream stream;
+    stream << "{\n"
+           << "  \"version\": \"" << getVersion() << "\",\n"
+           << "  \"folder\": " << jsonString(options.folder) << ",\n"
+           << "  \"source\": " << jsonString(source) << ",\n"
+           << "  \"positions\": " << positionCnt << ",\n"
+           << "  \"cores\": " << std::thread::hardware_concurrency() << ",\n"
+           << "  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        auto& r = results[i];
+        stream << "    { \"op\": \"" << r.op << "\", \"memMode\": \"" << r.memMode << "\", \"threads\": " << r.threadCnt
+               << ", \"phase\": \"" << r.phase << "\", \"calls\": " << r.calls << ", \"seconds\": " << r.seconds
+               << ", \"callsPerSecond\": " << (i64)(r.calls / MAX(r.seconds, 1e-9))
+               << ", \"p50Ns\": " << (i64)r.p50 << ", \"p99Ns\": " << (i64)r.p99
+               << ", \"checksum\": \"" << std::hex << r.checksum << std::dec << "\""
+               << ", \"stats\": { ";
+        const char* sep = "";
+#define JSON_COUNTER(name) stream << sep << "\"" #name "\": " << r.stats.name; sep = ", ";
+        chess_STATS_COUNTERS(JSON_COUNTER)
+#undef JSON_COUNTER
+        stream << " } }"
+               << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    stream << "  ]\n}\n";
+    return stream.str();
+}
+
+static bool parseOptions(int argc, const char* argv[], Options& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            return false;
+        }
+        std::string value = argv[++i];
+        if (arg == "-d") options.folder = value;
+        else if (arg == "-fen") options.fenPath = value;
+        else if (arg == "-m") options.memModes = split(value);
+        else if (arg == "-n") options.scoreCnt = std::atoll(value.c_str());
+        else if (arg == "-np") options.probeCnt = std::atoll(value.c_str());
+        else if (arg == "-p") options.positionCnt = std::atoi(value.c_str());
+        else if (arg == "-o") options.outPath = value;
+        else if (arg == "-t") {
+            options.threadCnts.clear();
+            for (auto && s : split(value)) {
+                options.threadCnts.push_back(MAX(1, std::atoi(s.c_str())));
+            }
+        } else {
+            return false;
+        }
+    }
+
+    if (options.threadCnts.empty()) {
+        int coreCnt = MAX(1, (int)std::thread::hardware_concurrency());
+        for (int threadCnt = 1; threadCnt < coreCnt; threadCnt *= 2) {
+            options.threadCnts.push_back(threadCnt);
+        }
+        options.threadCnts.push_back(coreCnt);
+    }
+    return !options.memModes.empty();
+}
+
+int main(int argc, const char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::cerr << "Usage: benchsuite [-d folder] [-fen file] [-m tiny,all,smart] [-t 1,2,4] [-n probes] [-np probes] [-p positions] [-o file]" << std::endl;
+        return -1;
+    }
+
+    // Positions are set up with a database of their own, the benchmarked ones start cold
+    chessDb posDb;
+    posDb.preload(options.folder, chessMemMode::tiny, chessLoadMode::onrequest);
+    if (posDb.getSize() == 0) {
+        std::cerr << "Error: could not load any endgames from folder " << options.folder << std::endl;
+        return -1;
+    }
+
+    auto boards = options.fenPath.empty() ? createBoards(posDb, options.positionCnt, 0x2f6b) : readBoards(posDb, options.fenPath);
+    if (boards.empty()) {
+        std::cerr << "Error: could not create any position" << std::endl;
+        return -1;
+    }
+
+    std::cout << "endgames: " << posDb.getSize() << ", positions: " << boards.size() << std::endl;
+    std::cout << std::left << std::setw(10) << "op" << std::setw(12) << "memMode" << std::right << std::setw(8) << "threads"
+              << std::setw(7) << "phase" << std::setw(12) << "calls" << std::setw(14) << "calls/s"
+              << std::setw(10) << "p50 ns" << std::setw(12) << "p99 ns" << std::endl;
+
+    std::vector<RunResult> results;
+    for (auto useProbe : { false, true }) {
+        for (auto && memMode : options.memModes) {
+            for (auto threadCnt : options.threadCnts) {
+                chessDb db;
+                db.preload(options.folder, parseMemMode(memMode, chessMemMode::tiny), chessLoadMode::onrequest);
+
+                auto cold = runPhase(db, boards, useProbe, threadCnt, ((i64)boards.size() + threadCnt - 1) / threadCnt, threadCnt);
+                cold.phase = "cold";
+                auto warm = runPhase(db, boards, useProbe, threadCnt, useProbe ? options.probeCnt : options.scoreCnt, 1);
+                warm.phase = "warm";
+
+                for (auto r : { cold, warm }) {
+                    r.op = useProbe ? "probe" : "getScore";
+                    r.memMode = memMode;
+                    std::cout << std::left << std::setw(10) << r.op << std::setw(12) << r.memMode << std::right << std::setw(8) << r.threadCnt
+                              << std::setw(7) << r.phase << std::setw(12) << r.calls << std::setw(14) << (i64)(r.calls / MAX(r.seconds, 1e-9))
+                              << std::setw(10) << (i64)r.p50 << std::setw(12) << (i64)r.p99 << std::endl;
+                    results.push_back(r);
+                }
+            }
+        }
+    }
+
+    auto json = toJson(options, options.fenPath.empty() ? "random" : options.fenPath, boards.size(), results);
+    if (options.outPath == "-") {
+        std::cout << json;
+    } else {
+        std::ofstream file(options.outPath);
+        file << json;
+        if (!file) {
+            std::cerr << "Error: cannot write " << options.outPath << std::endl;
+            return -1;
+        }
+        std::cout << "Results written to " << options.outPath << std::endl;
+    }
+    return 0;
+}
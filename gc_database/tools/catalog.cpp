@@ -0,0 +1,96 @@
+#include <iostream>
+#include <chrono>
+
+#include "chess.h"
+
+using namespace chess;
+
+/*
+ * Writes the catalog of a folder and checks it
+ *
+ * Usage: catalog [folder] [check]
+ *
+ * The catalog is written (unless check is given), then the folder is set up twice with memMode tiny and
+ * loadMode loadnow, by listing folders and reading files, then from the catalog. Times are printed,
+ * both must have the same files, headers and block tables
+ */
+
+static double preloadTime(chessDb& db, const std::string& folder, bool useCatalog) {
+    db.setUseCatalog(useCatalog);
+    auto startTime = std::chrono::steady_clock::now();
+    db.preload(folder, chessMemMode::tiny, chessLoadMode::loadnow);
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+static bool isSame(const chessFile& file, const chessFile& refFile) {
+    if (file.getName() != refFile.getName() || file.loadStatus != refFile.loadStatus
+        || (file.header == nullptr) != (refFile.header == nullptr)) {
+        return false;
+    }
+    if (file.header == nullptr) {
+        return true;
+    }
+    if (memcmp(file.header, refFile.header, chess_HEADER_SIZE)) {
+        return false;
+    }
+
+    for (int sd = 0; sd < 2; sd++) {
+        if (file.getPath(sd) != refFile.getPath(sd) || (file.compressBlockTables[sd] == nullptr) != (refFile.compressBlockTables[sd] == nullptr)) {
+            return false;
+        }
+        if (file.compressBlockTables[sd]
+            && memcmp(file.compressBlockTables[sd], refFile.compressBlockTables[sd], file.getCompresseBlockCount() * sizeof(u32))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, const char* argv[]) {
+    std::string folder = argc > 1 ? argv[1] : "./databases/3";
+    bool checkOnly = argc > 2 && std::string(argv[2]) == "check";
+
+    chessVerbose = true;
+
+    if (!checkOnly) {
+        auto startTime = std::chrono::steady_clock::now();
+        if (!chessCatalog::create(folder)) {
+            std::cerr << "Error: cannot create the catalog of " << folder << std::endl;
+            return 1;
+        }
+        auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+        std::cout << "Written " << chessCatalog::getPath(folder) << " in " << elapsed << " s" << std::endl;
+    }
+
+    chessCatalog catalog;
+    if (!catalog.open(folder)) {
+        std::cerr << "Error: no up-to-date catalog in " << folder << std::endl;
+        return 1;
+    }
+    int staleCnt = 0;
+    for (int i = 0; i < catalog.getEntryCnt(); i++) {
+        if (!catalog.isUpToDate(catalog.getEntry(i))) {
+            std::cout << "Out of date: " << catalog.getPath(catalog.getEntry(i)) << std::endl;
+            staleCnt++;
+        }
+    }
+    std::cout << "Entries: " << catalog.getEntryCnt() << ", out of date: " << staleCnt << std::endl;
+    catalog.close();
+
+    chessDb refDb, db;
+    auto refTime = preloadTime(refDb, folder, false);
+    auto catalogTime = preloadTime(db, folder, true);
+    std::cout << "Files: " << refDb.getSize() << ", listing " << refTime << " s, catalog " << catalogTime << " s" << std::endl;
+
+    int errCnt = refDb.getSize() != db.getSize();
+    for (auto && refFile : refDb.chessFileVec) {
+        auto file = db.getchessFile(refFile->getName());
+        if (file == nullptr || !isSame(*file, *refFile)) {
+            std::cerr << "Error: " << refFile->getName() << " differs" << std::endl;
+            errCnt++;
+        }
+    }
+
+    std::cout << (errCnt ? "failed" : "passed") << std::endl;
+    return errCnt ? 1 : 0;
+}
@@ -0,0 +1,74 @@
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include "chess.h"
+
+using namespace chess;
+
+/*
+ * Derives missing sides of endgames and checks them
+ *
+ * Usage: derivetb [folder] [threads] [save] [checks per endgame]
+ *
+ * Endgames having one side only get the other side by one-ply searches (chessDb::deriveMissingSides),
+ * save writes them next to the files. Scores of random positions are compared with the ones
+ * of a database without derived sides (one-ply searches on probing)
+ */
+
+int main(int argc, const char* argv[]) {
+    std::string folder = argc > 1 ? argv[1] : "./chess";
+    int threadCnt = argc > 2 ? std::atoi(argv[2]) : 0;
+    bool persist = argc > 3 && std::string(argv[3]) == "save";
+    int checkCnt = argc > 4 ? std::atoi(argv[4]) : 100000;
+
+    chessVerbose = true;
+
+    chessDb db, refDb;
+    db.addFolders(folder);
+    db.preload(chessMemMode::tiny, chessLoadMode::onrequest);
+    refDb.addFolders(folder);
+    refDb.preload(chessMemMode::tiny, chessLoadMode::onrequest);
+
+    auto startTime = std::chrono::steady_clock::now();
+    db.deriveMissingSides(threadCnt, persist);
+    db.waitForDerive();
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    std::cout << "Derived all in " << elapsed << " s" << std::endl;
+
+    std::mt19937_64 rng(2017);
+    i64 checked = 0, errCnt = 0;
+
+    for(auto && pchessFile : db.chessFileVec) {
+        if (pchessFile->loadStatus != chessLoadStatus::loaded) {
+            continue;
+        }
+
+        for(int i = 0; i < checkCnt; i++) {
+            chessProbeBoard board;
+            auto idx = (i64)(rng() % (u64)pchessFile->getSize());
+            if (!pchessFile->setupBoard(board, idx, FlipMode::none, Side::white)) {
+                continue;
+            }
+
+            board.side = rng() & 1 ? Side::white : Side::black;
+            if (board.isIncheck(getXSide(board.side))) {
+                continue;
+            }
+
+            checked++;
+            auto score = db.getScore(board), refScore = refDb.getScore(board);
+            if (score != refScore) {
+                if (errCnt < 20) {
+                    std::cerr << "Error: " << pchessFile->getName() << ", " << board.getFen()
+                              << ", score " << score << ", expected " << refScore << std::endl;
+                }
+                errCnt++;
+            }
+        }
+    }
+
+    std::cout << "Checked " << checked << " positions, " << errCnt << " errors" << std::endl;
+    return errCnt ? 1 : 0;
+}
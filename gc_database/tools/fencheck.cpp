@@ -0,0 +1,116 @@
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "chess.h"
+
+using namespace chess;
+
+/*
+ * Check of FEN parsing (chessBoardCore::setFen) for chessBoard and chessBitBoard
+ *
+ * Usage: fencheck
+ *
+ * Valid FENs must read the same with both setFen and survive getFen / setFen. Then every byte value
+ * (NUL too, setFen with a length reads past it) is put in place of a piece: piece letters must give that
+ * piece, any other byte or a second king must give an invalid FEN (no side), as must more pieces than
+ * the piece list holds. Keys must always match the piece list
+ */
+
+static const char* validFens[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "8/8/8/3K4/1k6/1N6/8/8 w - - 0 1",
+    "2K1k3/8/8/8/8/1n6/8/1Q6 b - - 0 1",
+    "4k3/8/8/2pP4/8/8/8/4K3 w - c6 0 1",
+    "r3k2r/8/8/8/8/8/8/R3K2R b KQkq - 0 1",
+};
+
+// The knight on b3 of this FEN is replaced by each byte
+static const char* byteFen = "8/8/8/3K4/1k6/1N6/8/8 w - - 0 1";
+#define BYTE_FEN_POS    15
+#define BYTE_FEN_SQUARE 41
+
+static bool isConsistent(const chessBoardCore& board) {
+    return board.hashKey == chessBoardCore::pieceList_hashKey((const Piece*)board.pieceList)
+        && board.materialKey == chessBoardCore::pieceList_materialKey((const Piece*)board.pieceList);
+}
+
+template <class Board>
+static int checkBoard(const char* boardName) {
+    int errCnt = 0;
+    auto report = [&](const std::string& msg) {
+        if (errCnt < 20) {
+            std::cerr << "Error: " << boardName << ", " << msg << std::endl;
+        }
+        errCnt++;
+    };
+
+    for (auto && fen : validFens) {
+        Board board, board2, board3;
+        board.setFen(std::string(fen));
+        board2.setFen(fen, strlen(fen));
+        board3.setFen(board.getFen());
+
+        if (board.side == Side::none || !isConsistent(board)) {
+            report(std::string("cannot read ") + fen);
+        }
+        if (board2.getFen() != board.getFen() || board2.hashKey != board.hashKey || board2.materialKey != board.materialKey) {
+            report(std::string("setFen with a length differs for ") + fen);
+        }
+        if (board3.getFen() != board.getFen() || board3.hashKey != board.hashKey) {
+            report(std::string("getFen does not read back for ") + fen);
+        }
+    }
+
+    std::string pieceChars = "kqrbnpKQRBNP";
+    for (int ch = 0; ch < 256; ch++) {
+        std::string fen = byteFen;
+        fen[BYTE_FEN_POS] = (char)ch;
+
+        // Empty squares and separators change the layout
+        if ((ch >= '0' && ch <= '8') || ch == '/' || ch == ' ') {
+            continue;
+        }
+
+        Board board;
+        board.setFen(fen.c_str(), fen.size());
+
+        if (!isConsistent(board)) {
+            report("keys do not match pieces for byte " + std::to_string(ch));
+        }
+
+        // Kings are there already, a second one is invalid
+        auto k = pieceChars.find((char)ch);
+        if (ch && k != std::string::npos && k % 6 != 0) {
+            auto piece = board.getPiece(BYTE_FEN_SQUARE);
+            if (board.side != Side::white || piece.type != static_cast<PieceType>(k % 6) || piece.side != (k < 6 ? Side::black : Side::white)) {
+                report("wrong piece for byte " + std::to_string(ch));
+            }
+        } else if (board.side != Side::none) {
+            report("byte " + std::to_string(ch) + " is taken as a piece");
+        }
+    }
+
+    // A side has 15 pieces besides its king at most
+    std::pair<const char*, bool> countFens[] = {
+        { "4k3/8/8/8/8/1PPPPPPP/PPPPPPPP/4K3 w - - 0 1", true },
+        { "4k3/8/8/8/8/PPPPPPPP/PPPPPPPP/4K3 w - - 0 1", false },
+    };
+    for (auto && countFen : countFens) {
+        Board board;
+        board.setFen(countFen.first, strlen(countFen.first));
+        if ((board.side == Side::white) != countFen.second || !isConsistent(board)) {
+            report(std::string("wrong piece count check for ") + countFen.first);
+        }
+    }
+
+    std::cout << boardName << ": " << errCnt << " errors" << std::endl;
+    return errCnt;
+}
+
+int main() {
+    auto errCnt = checkBoard<chessBoard>("chessBoard") + checkBoard<chessBitBoard>("chessBitBoard");
+
+    std::cout << (errCnt ? "failed" : "passed") << std::endl;
+    return errCnt ? 1 : 0;
+}
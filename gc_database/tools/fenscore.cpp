@@ -0,0 +1,165 @@
+#include <iostream>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <future>
+#include <memory>
+#include <vector>
+
+#include "chess.h"
+#include "chesspool.h"
+
+using namespace chess;
+
+/*
+ * Scores of many positions, one FEN a line, read from a file or stdin and written to stdout in the same order
+ *
+ * Usage: fenscore [folder] [threads] [file|-] [tiny|all|smart|mapped|compressed]
+ *
+ * Input is read in big chunks, each one (whole lines) is a batch. Lines are parsed in place (setFen without
+ * strings) and probed together by chessDb::getScoreBatch on a pool of threads (0: number of cores). Batches
+ * are written in input order as they are done, a few batches per thread are in flight.
+ * Each output line is the score for the side to move, or "invalid" for a line which is not a legal position
+ */
+
+#define BATCH_BYTES         (256 * 1024)
+#define BATCHES_PER_THREAD  4
+
+class Batch {
+public:
+    std::vector<char> text;     // whole lines
+    std::vector<char> output;
+    i64     lineCnt = 0;
+};
+
+static void scoreBatch(chessDb& db, Batch& batch) {
+    // Reused by batches of the thread
+    thread_local std::vector<std::pair<size_t, size_t>> lines;
+    thread_local std::vector<chessProbeBoard> boards;
+    thread_local std::vector<chessBoardCore*> legalBoards;
+    thread_local std::vector<int> scores;
+
+    lines.clear();
+    auto text = batch.text.data();
+    for (size_t begin = 0, end; begin < batch.text.size(); begin = end + 1) {
+        auto p = (const char*)memchr(text + begin, '\n', batch.text.size() - begin);
+        end = p ? (size_t)(p - text) : batch.text.size();
+        auto len = end - begin;
+        if (len && text[begin + len - 1] == '\r') {
+            len--;
+        }
+        lines.push_back({ begin, len });
+    }
+    batch.lineCnt = (i64)lines.size();
+
+    if (boards.size() < lines.size()) {
+        boards.resize(lines.size());
+    }
+    legalBoards.clear();
+    for (size_t i = 0; i < lines.size(); i++) {
+        auto& board = boards[i];
+        board.setFen(text + lines[i].first, lines[i].second);
+        if (board.isLegal()) {
+            legalBoards.push_back(&board);
+        }
+    }
+
+    scores.resize(legalBoards.size());
+    db.getScoreBatch(legalBoards.data(), (int)legalBoards.size(), scores.data());
+
+    static const char invalid[] = "invalid\n";
+    batch.output.resize(lines.size() * 8 + 16);
+    auto out = batch.output.data();
+    for (size_t i = 0, k = 0; i < lines.size(); i++) {
+        if (k < legalBoards.size() && legalBoards[k] == &boards[i]) {
+            out = std::to_chars(out, out + 8, scores[k++]).ptr;
+            *out++ = '\n';
+        } else {
+            memcpy(out, invalid, sizeof(invalid) - 1);
+            out += sizeof(invalid) - 1;
+        }
+    }
+    batch.output.resize(out - batch.output.data());
+    batch.text = std::vector<char>();
+}
+
+// Next batch of whole lines, the part of the last line is kept in carry for the next batch
+static std::unique_ptr<Batch> readBatch(FILE* file, std::vector<char>& carry) {
+    std::unique_ptr<Batch> batch(new Batch());
+    auto& text = batch->text;
+    text.swap(carry);
+    auto carrySize = text.size();
+    text.resize(carrySize + BATCH_BYTES);
+    auto n = fread(text.data() + carrySize, 1, BATCH_BYTES, file);
+    text.resize(carrySize + n);
+
+    if (n == BATCH_BYTES) {
+        // A line longer than a batch stays in carry
+        auto end = text.size();
+        while (end > 0 && text[end - 1] != '\n') {
+            end--;
+        }
+        carry.assign(text.begin() + end, text.end());
+        text.resize(end);
+    }
+
+    if (text.empty() && n == BATCH_BYTES) {
+        return readBatch(file, carry);
+    }
+    return text.empty() ? nullptr : std::move(batch);
+}
+
+int main(int argc, const char* argv[]) {
+    std::string folder = argc > 1 ? argv[1] : "./chess";
+    int threadCnt = argc > 2 ? std::atoi(argv[2]) : 0;
+    std::string path = argc > 3 ? argv[3] : "-";
+    auto memMode = parseMemMode(argc > 4 ? argv[4] : "smart");
+
+    chessDb db;
+    db.preload(folder, memMode, chessLoadMode::onrequest);
+    if (db.getSize() == 0) {
+        std::cerr << "Error: could not load any endgames from folder " << folder << std::endl;
+        return -1;
+    }
+
+    auto file = path == "-" ? stdin : fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        std::cerr << "Error: cannot open " << path << std::endl;
+        return -1;
+    }
+
+    chessThreadPool pool(threadCnt);
+    std::deque<std::pair<std::future<void>, std::unique_ptr<Batch>>> inFlight;
+    i64 lineCnt = 0;
+
+    auto writeFront = [&]() {
+        auto& front = inFlight.front();
+        front.first.get();
+        fwrite(front.second->output.data(), 1, front.second->output.size(), stdout);
+        lineCnt += front.second->lineCnt;
+        inFlight.pop_front();
+    };
+
+    auto startTime = std::chrono::steady_clock::now();
+    std::vector<char> carry;
+    for (std::unique_ptr<Batch> batch; (batch = readBatch(file, carry)) != nullptr;) {
+        auto pBatch = batch.get();
+        inFlight.emplace_back(pool.submit([&db, pBatch]() { scoreBatch(db, *pBatch); }), std::move(batch));
+        while ((int)inFlight.size() >= pool.getThreadCnt() * BATCHES_PER_THREAD) {
+            writeFront();
+        }
+    }
+    while (!inFlight.empty()) {
+        writeFront();
+    }
+    fflush(stdout);
+
+    if (file != stdin) {
+        fclose(file);
+    }
+
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    std::cerr << "Positions: " << lineCnt << ", " << elapsed << " s, " << (i64)(lineCnt / MAX(elapsed, 1e-9)) << " positions/s" << std::endl;
+    return 0;
+}
@@ -0,0 +1,71 @@
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "chess.h"
+#include "chessgen.h"
+
+using namespace chess;
+
+/*
+ * Generator of endgames
+ *
+ * Usage: gentb [-f folder]... [-t threads] [-s w|b|wb] [-v] <output folder> <name>...
+ *
+ * Endgames are generated in the given order, each one could use the ones generated before it
+ * (the output folder is a folder of sub-endgames too). Sub-endgames (after captures and promotions)
+ * must be in the output folder or the folders given by -f
+ */
+
+int main(int argc, char** argv) {
+    std::vector<std::string> folders, names;
+    std::string outFolder;
+    int threadCnt = 0, sideMask = (1 << W) | (1 << B);
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-f" && i + 1 < argc) {
+            folders.push_back(argv[++i]);
+        } else if (arg == "-t" && i + 1 < argc) {
+            threadCnt = atoi(argv[++i]);
+        } else if (arg == "-s" && i + 1 < argc) {
+            std::string s = argv[++i];
+            sideMask = (s.find('w') != std::string::npos ? 1 << W : 0) | (s.find('b') != std::string::npos ? 1 << B : 0);
+        } else if (arg == "-v") {
+            chessVerbose = true;
+        } else if (outFolder.empty()) {
+            outFolder = arg;
+        } else {
+            names.push_back(arg);
+        }
+    }
+
+    if (outFolder.empty() || names.empty() || sideMask == 0) {
+        std::cerr << "Usage: gentb [-f folder]... [-t threads] [-s w|b|wb] [-v] <output folder> <name>..." << std::endl;
+        return 1;
+    }
+    folders.push_back(outFolder);
+
+    chessDb db;
+    chessGenerator generator(db, threadCnt);
+    std::cout << "threads: " << generator.getThreadCnt() << std::endl;
+
+    for (auto && name : names) {
+        // Reload to see the ones just generated
+        db.closeAll();
+        for (auto && folder : folders) {
+            db.addFolders(folder);
+        }
+        db.preload(chessMemMode::all, chessLoadMode::onrequest);
+
+        auto startTime = std::chrono::steady_clock::now();
+        if (!generator.generate(name, outFolder, sideMask)) {
+            std::cerr << "Error: cannot generate " << name << std::endl;
+            return 1;
+        }
+        auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+        std::cout << name << ": " << elapsed << " s" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,118 @@
+#include <iostream>
+#include <chrono>
+#include <iomanip>
+#include <random>
+#include <vector>
+
+#include "chess.h"
+
+using namespace chess;
+
+/*
+ * Key computing benchmark, generic code (chessKey::getKey) vs specialised code of endgames
+ *
+ * Usage: keybench [keys per endgame] [endgame names...]
+ *
+ * It needs no file, positions are set up from random indexes then half of them get colours swapped
+ * (the weak side is white) and some are mirrored. Both codes must give the same keys. A few thousand
+ * positions are used again and again thus they stay in the CPU caches
+ */
+
+#define POSITION_CNT    4096
+
+static const char* benchNames[] = {
+    "kqk", "krk", "kpk", "kbnk", "kqkr", "krkp", "kpkp", "kqpkq", "krpkr", "kppkp", "kqqqk"
+};
+
+class Position {
+public:
+    Piece pieceList[2][16];
+};
+
+static std::vector<Position> createPositions(const chessFile& file, int cnt, u64 seed) {
+    std::vector<Position> positions;
+    std::mt19937_64 rng(seed);
+
+    chessProbeBoard board;
+    for (int tried = 0; (int)positions.size() < cnt && tried < cnt * 100; tried++) {
+        auto idx = (i64)(rng() % (u64)file.getSize());
+        if (!file.setupBoard(board, idx, FlipMode::none, Side::white)) {
+            continue;
+        }
+
+        Position position;
+        bool swapColors = rng() & 1, mirror = rng() & 2;
+        for (int sd = 0; sd < 2; sd++) {
+            for (int i = 0; i < 16; i++) {
+                auto p = board.pieceList[swapColors ? 1 - sd : sd][i];
+                if (!p.isEmpty()) {
+                    p.side = static_cast<Side>(sd);
+                    p.idx = chessBoardCore::flip(p.idx, swapColors ? FlipMode::vertical : FlipMode::none);
+                    p.idx = chessBoardCore::flip(p.idx, mirror ? FlipMode::horizontal : FlipMode::none);
+                }
+                position.pieceList[sd][i] = p;
+            }
+        }
+        positions.push_back(position);
+    }
+    return positions;
+}
+
+int main(int argc, const char* argv[]) {
+    int keyCnt = argc > 1 ? std::atoi(argv[1]) : 10000000;
+
+    std::vector<std::string> names;
+    if (argc > 2) {
+        names.assign(argv + 2, argv + argc);
+    } else {
+        names.assign(std::begin(benchNames), std::end(benchNames));
+    }
+
+    std::cout << std::left << std::setw(10) << "endgame" << std::right << std::setw(14) << "generic M/s"
+              << std::setw(16) << "specialised M/s" << std::setw(10) << "speedup" << std::setw(8) << "errors" << std::endl;
+
+    i64 errCnt = 0;
+    for (auto && name : names) {
+        chessFile file;
+        file.setupIdxComputing(name, 0, 3);
+
+        auto positions = createPositions(file, MIN(keyCnt, POSITION_CNT), 2017);
+        auto roundCnt = MAX(1, keyCnt / (int)positions.size());
+        std::vector<chessKeyRec> genericRecs(positions.size());
+        i64 sum = 0;
+
+        auto startTime = std::chrono::steady_clock::now();
+        for (int r = 0; r < roundCnt; r++) {
+            for (size_t i = 0; i < positions.size(); i++) {
+                chessKey::getKey(genericRecs[i], positions[i].pieceList, file.idxArr, file.idxMult, 0);
+                sum += genericRecs[i].key;
+            }
+        }
+        auto genericTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+        i64 errors = 0;
+        startTime = std::chrono::steady_clock::now();
+        for (int r = 0; r < roundCnt; r++) {
+            for (size_t i = 0; i < positions.size(); i++) {
+                auto rec = file.getPieceListKey(positions[i].pieceList);
+                sum -= rec.key;
+                errors += rec.key != genericRecs[i].key || rec.flipSide != genericRecs[i].flipSide;
+            }
+        }
+        auto specialisedTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+        errCnt += errors + (sum != 0);
+
+        auto n = (double)positions.size() * roundCnt / 1e6;
+        std::cout << std::left << std::setw(10) << name << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(14) << n / genericTime;
+        if (file.keyEncoder) {
+            std::cout << std::setw(16) << n / specialisedTime << std::setw(9) << std::setprecision(2) << genericTime / specialisedTime << "x";
+        } else {
+            std::cout << std::setw(16) << "-" << std::setw(10) << "-";
+        }
+        std::cout << std::setw(8) << errors << std::endl;
+    }
+
+    std::cout << (errCnt ? "failed" : "passed") << std::endl;
+    return errCnt ? 1 : 0;
+}
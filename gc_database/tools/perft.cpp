@@ -0,0 +1,84 @@
+#include <iostream>
+#include <chrono>
+#include <vector>
+
+#include "chess.h"
+
+using namespace chess;
+
+/*
+ * Perft for comparing the mailbox (chessBoard) and the bitboard (chessBitBoard) boards
+ *
+ * Usage: perft [depth] [fen]
+ *
+ * It counts leaf nodes of all legal moves up to the depth for some endgame positions
+ * (or the given one) with both boards, prints out nodes per second and reports
+ * if their counts are different
+ */
+
+static const char* perftFens[] = {
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1",
+    "8/8/3k4/8/3PP3/8/8/3K3R w - - 0 1",
+    "4k3/8/8/3q4/8/8/3RB3/4K3 w - - 0 1",
+};
+
+template <class Board>
+static i64 perft(Board& board, Side side, int depth) {
+    MoveList moveList;
+    board.gen(moveList, side, false);
+
+    i64 nodes = 0;
+    Hist hist;
+    for (int i = 0; i < moveList.end; i++) {
+        board.make(moveList.list[i], hist);
+        if (!board.isIncheck(side)) {
+            nodes += depth > 1 ? perft(board, getXSide(side), depth - 1) : 1;
+        }
+        board.takeBack(hist);
+    }
+    return nodes;
+}
+
+template <class Board>
+static i64 runPerft(const std::string& fen, int depth, const char* boardName) {
+    Board board;
+    board.setFen(fen);
+
+    auto startTime = std::chrono::steady_clock::now();
+    auto nodes = perft(board, board.side, depth);
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    std::cout << "  " << boardName << ": " << nodes << " nodes, " << elapsed << " s, "
+              << (i64)(nodes / MAX(elapsed, 1e-9)) << " nodes/s" << std::endl;
+    return nodes;
+}
+
+int main(int argc, const char* argv[]) {
+    int depth = argc > 1 ? std::atoi(argv[1]) : 5;
+
+    std::vector<std::string> fens;
+    if (argc > 2) {
+        fens.push_back(argv[2]);
+    } else {
+        fens.insert(fens.end(), std::begin(perftFens), std::end(perftFens));
+    }
+
+    int errCnt = 0;
+    for (auto && fen : fens) {
+        std::cout << fen << ", depth " << depth << std::endl;
+        auto mailboxNodes = runPerft<chessBoard>(fen, depth, "mailbox ");
+        auto bitboardNodes = runPerft<chessBitBoard>(fen, depth, "bitboard");
+        if (mailboxNodes != bitboardNodes) {
+            std::cerr << "Error: node counts are different" << std::endl;
+            errCnt++;
+        }
+    }
+
+#ifdef chess_USE_PEXT
+    std::cout << "sliding attacks: pext" << std::endl;
+#else
+    std::cout << "sliding attacks: magic" << std::endl;
+#endif
+    return errCnt ? 1 : 0;
+}
@@ -0,0 +1,115 @@
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "chess.h"
+
+using namespace chess;
+
+/*
+ * Multi-threaded probe benchmark
+ *
+ * Usage: probebench [folder] [tiny|all|smart|mapped|compressed] [max threads] [probes per thread] [score cache entries]
+ *
+ * It probes random positions of all loaded endgames with 1, 2, 4... threads and
+ * prints out the throughput and the speedup comparing with one thread
+ */
+
+static std::vector<chessProbeBoard> createBoards(chessDb& db, int cnt, u64 seed) {
+    std::vector<chessProbeBoard> boards;
+    std::mt19937_64 rng(seed);
+
+    for (int tried = 0; (int)boards.size() < cnt && tried < cnt * 100; tried++) {
+        auto pchessFile = db.chessFileVec[rng() % db.chessFileVec.size()];
+        pchessFile->checkToLoadHeaderAndTable();
+        if (pchessFile->loadStatus != chessLoadStatus::loaded) {
+            continue;
+        }
+
+        chessProbeBoard board;
+        auto idx = (i64)(rng() % (u64)pchessFile->getSize());
+        if (!pchessFile->setupBoard(board, idx, FlipMode::none, Side::white)) {
+            continue;
+        }
+
+        board.side = rng() & 1 ? Side::white : Side::black;
+        if (board.isIncheck(getXSide(board.side))) {
+            continue;
+        }
+        boards.push_back(board);
+    }
+    return boards;
+}
+
+int main(int argc, const char* argv[]) {
+    std::string folder = argc > 1 ? argv[1] : "./chess";
+    std::string memModeString = argc > 2 ? argv[2] : "tiny";
+    int maxThreadCnt = argc > 3 ? std::atoi(argv[3]) : (int)std::thread::hardware_concurrency();
+    i64 probeCnt = argc > 4 ? std::atoll(argv[4]) : 1000000;
+    int scoreCacheSize = argc > 5 ? std::atoi(argv[5]) : chess_SCORE_CACHE_SIZE;
+
+    maxThreadCnt = MAX(1, maxThreadCnt);
+
+    chessDb db;
+    db.setScoreCacheSize(scoreCacheSize);
+    db.preload(folder, parseMemMode(memModeString, chessMemMode::tiny), chessLoadMode::loadnow);
+    if (db.getSize() == 0) {
+        std::cerr << "Error: could not load any endgames from folder " << folder << std::endl;
+        return -1;
+    }
+
+    auto boards = createBoards(db, 1 << 14, 0x2f6b);
+    if (boards.empty()) {
+        std::cerr << "Error: could not create any position" << std::endl;
+        return -1;
+    }
+
+    std::cout << "endgames: " << db.getSize() << ", positions: " << boards.size() << ", memory mode: " << memModeString << std::endl;
+
+    double oneThreadSpeed = 0;
+    for (int threadCnt = 1; threadCnt <= maxThreadCnt; threadCnt *= 2) {
+        std::vector<std::thread> threads;
+        std::vector<u64> checksums(threadCnt);
+
+        auto start = std::chrono::steady_clock::now();
+
+        for (int t = 0; t < threadCnt; t++) {
+            threads.emplace_back([&, t]() {
+                auto myBoards = boards; // getScore may make/take back moves on the board
+                u64 checksum = 0;
+                for (i64 i = 0, j = t * 997; i < probeCnt; i++, j++) {
+                    auto& board = myBoards[j % myBoards.size()];
+                    checksum += db.getScore(board);
+                }
+                checksums[t] = checksum;
+            });
+        }
+
+        for (auto && thread : threads) {
+            thread.join();
+        }
+
+        auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        auto speed = (double)probeCnt * threadCnt / elapsed;
+        if (threadCnt == 1) {
+            oneThreadSpeed = speed;
+        }
+
+        std::cout << "threads: " << threadCnt
+                  << ", probes/s: " << (i64)speed
+                  << ", speedup: " << speed / oneThreadSpeed
+                  << ", efficiency: " << speed / oneThreadSpeed / threadCnt * 100 << "%" << std::endl;
+
+        if (threadCnt < maxThreadCnt && threadCnt * 2 > maxThreadCnt) {
+            threadCnt = maxThreadCnt / 2;
+        }
+    }
+
+    std::cout << db.getBlockCacheStats().toString() << std::endl;
+    if (scoreCacheSize > 0) {
+        std::cout << db.getScoreCacheStats().toString() << std::endl;
+    }
+    return 0;
+}
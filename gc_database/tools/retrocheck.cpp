@@ -0,0 +1,233 @@
+#include <iostream>
+#include <chrono>
+#include <vector>
+
+#include "chess.h"
+
+using namespace chess;
+
+/*
+ * Consistency check of retro moves (genRetro, unmake, remake) with forward moves, for both
+ * the mailbox (chessBoard) and the bitboard (chessBitBoard) boards
+ *
+ * Usage: retrocheck [depth] [fen]
+ *
+ * It walks all legal moves up to the depth from some positions (or the given one). At each node:
+ * - every legal move must be found by genRetro after making it, unmake must bring back the node
+ *   and remake the position after the move
+ * - every retro move into the node (with a legal position before it) must be found by gen in that
+ *   position and make it must bring back the node
+ */
+
+static const char* retroFens[] = {
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1",
+    "8/8/3k4/8/3PP3/8/8/3K3R w - - 0 1",
+    "4k3/8/8/3q4/8/8/3RB3/4K3 w - - 0 1",
+    "4k3/1p6/8/2pP4/6p1/8/5P2/4K3 w - c6 0 1",
+    "r3k3/1P6/8/8/8/8/6p1/4K2R b - - 0 1",
+};
+
+class Counter {
+public:
+    i64 nodes = 0, moves = 0, retroMoves = 0, errors = 0;
+};
+
+static const std::string badPieceList = "bad piece list";
+
+// Pieces of squares, the piece list must have the same ones
+template <class Board>
+static std::string snapshot(const Board& board) {
+    std::string s(64, '.');
+    int cnt = 0;
+    for (int pos = 0; pos < 64; pos++) {
+        auto piece = board.getPiece(pos);
+        if (!piece.isEmpty()) {
+            s[pos] = piece.toString()[0];
+            cnt++;
+        }
+    }
+
+    for (int sd = 0; sd < 2; sd++) {
+        for (int i = 0; i < 16; i++) {
+            auto p = board.pieceList[sd][i];
+            if (!p.isEmpty()) {
+                cnt--;
+                if (!board.isPiece(p.idx, p.type, p.side)) {
+                    return badPieceList;
+                }
+            }
+        }
+    }
+    if (cnt || board.materialKey != chessBoardCore::pieceList_materialKey((const Piece *)board.pieceList) ||
+        board.hashKey != chessBoardCore::pieceList_hashKey((const Piece *)board.pieceList)) {
+        return badPieceList;
+    }
+    return s;
+}
+
+template <class Board>
+static bool reportError(Board& board, Counter& counter, const std::string& msg) {
+    if (counter.errors < 20) {
+        std::cerr << "Error: " << msg << ", " << board.getFen() << std::endl;
+    }
+    counter.errors++;
+    return false;
+}
+
+// Forward moves of side must be matched by retro moves
+template <class Board>
+static void checkForward(Board& board, Side side, Counter& counter) {
+    auto nodeSnapshot = snapshot(board);
+    MoveList moveList;
+    board.gen(moveList, side, false);
+
+    Hist hist, retroHist;
+    RetroMoveList retroList;
+    for (int i = 0; i < moveList.end; i++) {
+        auto move = moveList.list[i];
+        board.make(move, hist);
+        if (board.isIncheck(side)) {
+            board.takeBack(hist);
+            continue;
+        }
+        counter.moves++;
+
+        auto enpassant = move.type == PieceType::pawn && move.dest == hist.enpassant;
+        auto childSnapshot = snapshot(board);
+        auto childEnpassant = board.enpassant;
+
+        retroList.reset();
+        board.genRetro(retroList, side);
+
+        int k = 0;
+        for (; k < retroList.end; k++) {
+            auto& r = retroList.list[k];
+            if (r.move.from == move.from && r.move.dest == move.dest && r.move.promote == move.promote &&
+                r.cap == hist.cap.type && r.enpassant == enpassant) {
+                break;
+            }
+        }
+
+        if (k == retroList.end) {
+            reportError(board, counter, "no retro move for " + move.toString());
+        } else {
+            board.unmake(retroList.list[k], retroHist);
+            if (snapshot(board) != nodeSnapshot || (enpassant && board.enpassant != move.dest)) {
+                reportError(board, counter, "unmake " + retroList.list[k].toString());
+            }
+            board.remake(retroHist);
+            if (snapshot(board) != childSnapshot || board.enpassant != childEnpassant) {
+                reportError(board, counter, "remake " + retroList.list[k].toString());
+            }
+        }
+        board.takeBack(hist);
+    }
+}
+
+// Retro moves of the side which has just moved must be matched by forward moves
+template <class Board>
+static void checkBackward(Board& board, Side side, Counter& counter) {
+    auto xside = getXSide(side);
+    auto nodeSnapshot = snapshot(board);
+    auto nodeEnpassant = board.enpassant;
+
+    RetroMoveList retroList;
+    board.genRetro(retroList, xside);
+
+    Hist hist, retroHist;
+    MoveList moveList;
+    for (int i = 0; i < retroList.end; i++) {
+        auto& r = retroList.list[i];
+        board.unmake(r, retroHist);
+
+        if (snapshot(board) == badPieceList) {
+            reportError(board, counter, "unmake " + r.toString());
+        } else if (!board.isIncheck(side)) {
+            counter.retroMoves++;
+
+            moveList.reset();
+            board.gen(moveList, xside, false);
+            int k = 0;
+            for (; k < moveList.end; k++) {
+                auto& m = moveList.list[k];
+                if (m.from == r.move.from && m.dest == r.move.dest && m.promote == r.move.promote) {
+                    break;
+                }
+            }
+
+            if (k == moveList.end) {
+                reportError(board, counter, "no move for retro " + r.toString());
+            } else {
+                board.make(moveList.list[k], hist);
+                if (snapshot(board) != nodeSnapshot) {
+                    reportError(board, counter, "make " + r.toString());
+                }
+                board.takeBack(hist);
+            }
+        }
+
+        board.remake(retroHist);
+        if (snapshot(board) != nodeSnapshot || board.enpassant != nodeEnpassant) {
+            reportError(board, counter, "remake " + r.toString());
+        }
+    }
+}
+
+template <class Board>
+static void walk(Board& board, Side side, int depth, Counter& counter) {
+    counter.nodes++;
+    checkForward(board, side, counter);
+    checkBackward(board, side, counter);
+
+    if (depth <= 1) {
+        return;
+    }
+
+    MoveList moveList;
+    board.gen(moveList, side, false);
+    Hist hist;
+    for (int i = 0; i < moveList.end; i++) {
+        board.make(moveList.list[i], hist);
+        if (!board.isIncheck(side)) {
+            walk(board, getXSide(side), depth - 1, counter);
+        }
+        board.takeBack(hist);
+    }
+}
+
+template <class Board>
+static i64 runCheck(const std::string& fen, int depth, const char* boardName) {
+    Board board;
+    board.setFen(fen);
+
+    Counter counter;
+    auto startTime = std::chrono::steady_clock::now();
+    walk(board, board.side, depth, counter);
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    std::cout << "  " << boardName << ": " << counter.nodes << " nodes, " << counter.moves << " moves, "
+              << counter.retroMoves << " retro moves, " << counter.errors << " errors, " << elapsed << " s" << std::endl;
+    return counter.errors;
+}
+
+int main(int argc, const char* argv[]) {
+    int depth = argc > 1 ? std::atoi(argv[1]) : 3;
+
+    std::vector<std::string> fens;
+    if (argc > 2) {
+        fens.push_back(argv[2]);
+    } else {
+        fens.insert(fens.end(), std::begin(retroFens), std::end(retroFens));
+    }
+
+    i64 errCnt = 0;
+    for (auto && fen : fens) {
+        std::cout << fen << ", depth " << depth << std::endl;
+        errCnt += runCheck<chessBoard>(fen, depth, "mailbox ");
+        errCnt += runCheck<chessBitBoard>(fen, depth, "bitboard");
+    }
+
+    std::cout << (errCnt ? "failed" : "passed") << std::endl;
+    return errCnt ? 1 : 0;
+}
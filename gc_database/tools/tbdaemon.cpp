@@ -0,0 +1,313 @@
+#include <iostream>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "chess.h"
+#include "chesspool.h"
+
+using namespace chess;
+
+/*
+ * Query daemon: one chessDb stays loaded and answers requests over a Unix domain socket
+ *
+ * Usage: tbdaemon [folder] [socket path] [threads] [tiny|all|smart|mapped|compressed]
+ *
+ * Frames, all numbers little endian:
+ *   request:  u32 length (bytes after it), u32 id, u8 op, u8 reserved[3], u32 count,
+ *             count positions, each one u16 length + FEN
+ *   response: u32 length, u32 id, u8 op, u8 status, u16 reserved, u32 count, count results:
+ *             op 1 (score): i16 score
+ *             op 2 (probe): i16 score, u16 move count, moves of the line, 3 bytes each (from, dest, promotion)
+ *   Scores are for the side to move, chess_SCORE_ILLEGAL for a position which is not legal.
+ *   Status 0 is ok, 1 a bad request (no results). A broken frame length closes the connection
+ *
+ * A connection may send many requests without waiting (up to MAX_PENDING_REQUESTS are being answered,
+ * reading stops then). Requests are run by a pool of threads (0: number of cores), responses are sent as
+ * they are done thus they may come back out of order, ids tell them apart. SIGINT/SIGTERM stop the daemon
+ */
+
+#ifdef _WIN32
+
+int main() {
+    std::cerr << "Error: tbdaemon needs Unix domain sockets, it is not supported on Windows" << std::endl;
+    return -1;
+}
+
+#else
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define MAX_FRAME_SIZE          (64 * 1024 * 1024)
+#define MAX_PENDING_REQUESTS    64
+
+#define OP_SCORE                1
+#define OP_PROBE                2
+
+#define STATUS_OK               0
+#define STATUS_BAD_REQUEST      1
+
+static std::atomic<bool> stopping(false);
+
+static void onSignal(int) {
+    stopping = true;
+}
+
+class Connection {
+public:
+    explicit Connection(int _fd) : fd(_fd) {}
+    ~Connection() { ::close(fd); }
+
+    const int   fd;
+    std::mutex  writeMtx;
+
+    std::mutex  mtx;
+    std::condition_variable cv;
+    int         pendingCnt = 0;
+    std::atomic<bool> done { false };
+};
+
+static bool readFull(int fd, char* p, size_t len) {
+    while (len > 0) {
+        auto n = ::read(fd, p, len);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        len -= n;
+    }
+    return true;
+}
+
+static bool writeFull(int fd, const char* p, size_t len) {
+    while (len > 0) {
+        auto n = ::write(fd, p, len);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        p += n;
+        len -= n;
+    }
+    return true;
+}
+
+static u32 getU32(const char* p) {
+    return (u32)(u8)p[0] | (u32)(u8)p[1] << 8 | (u32)(u8)p[2] << 16 | (u32)(u8)p[3] << 24;
+}
+
+static void putU16(std::vector<char>& buf, u32 v) {
+    buf.push_back((char)v);
+    buf.push_back((char)(v >> 8));
+}
+
+static void putU32(std::vector<char>& buf, u32 v) {
+    putU16(buf, v);
+    putU16(buf, v >> 16);
+}
+
+// frame: the request after its length
+static std::vector<char> answer(chessDb& db, const std::vector<char>& frame) {
+    auto id = getU32(frame.data());
+    auto op = (u8)frame[4];
+    auto cnt = getU32(frame.data() + 8);
+
+    // FENs in place, boards are set up after the whole request is checked
+    std::vector<std::pair<const char*, size_t>> fens;
+    bool ok = op == OP_SCORE || op == OP_PROBE;
+    for (size_t pos = 12; ok && fens.size() < cnt; ) {
+        ok = pos + 2 <= frame.size();
+        if (ok) {
+            size_t len = (u8)frame[pos] | (u8)frame[pos + 1] << 8;
+            ok = pos + 2 + len <= frame.size();
+            fens.push_back({ frame.data() + pos + 2, len });
+            pos += 2 + len;
+        }
+    }
+
+    std::vector<char> response;
+    putU32(response, 0);
+    putU32(response, id);
+    response.push_back((char)op);
+    response.push_back(ok ? STATUS_OK : STATUS_BAD_REQUEST);
+    putU16(response, 0);
+    putU32(response, ok ? cnt : 0);
+    if (!ok) {
+        fens.clear();
+    }
+
+    std::vector<chessProbeBoard> boards(fens.size());
+    std::vector<chessBoardCore*> legalBoards;
+    for (size_t i = 0; i < fens.size(); i++) {
+        boards[i].setFen(fens[i].first, fens[i].second);
+        if (boards[i].isLegal()) {
+            legalBoards.push_back(&boards[i]);
+        }
+    }
+
+    if (op == OP_SCORE) {
+        std::vector<int> scores(legalBoards.size());
+        db.getScoreBatch(legalBoards.data(), (int)legalBoards.size(), scores.data());
+        for (size_t i = 0, k = 0; i < boards.size(); i++) {
+            auto legal = k < legalBoards.size() && legalBoards[k] == &boards[i];
+            putU16(response, (u32)(legal ? scores[k++] : chess_SCORE_ILLEGAL));
+        }
+    } else {
+        MoveList moveList;
+        for (size_t i = 0, k = 0; i < boards.size(); i++) {
+            moveList.reset();
+            auto score = chess_SCORE_ILLEGAL;
+            if (k < legalBoards.size() && legalBoards[k] == &boards[i]) {
+                k++;
+                score = db.probe(boards[i], moveList);
+            }
+            putU16(response, (u32)score);
+            putU16(response, (u32)moveList.end);
+            for (int j = 0; j < moveList.end; j++) {
+                auto& move = moveList.list[j];
+                response.push_back((char)move.from);
+                response.push_back((char)move.dest);
+                response.push_back((char)move.promote);
+            }
+        }
+    }
+
+    auto len = (u32)(response.size() - 4);
+    for (int i = 0; i < 4; i++) {
+        response[i] = (char)(len >> (8 * i));
+    }
+    return response;
+}
+
+// Reads requests of the connection until it is closed, its last task closes the socket
+static void serve(chessDb& db, chessThreadPool& pool, std::shared_ptr<Connection> conn) {
+    for (;;) {
+        char lenBuf[4];
+        if (!readFull(conn->fd, lenBuf, 4)) {
+            break;
+        }
+        auto len = getU32(lenBuf);
+        if (len < 12 || len > MAX_FRAME_SIZE) {
+            std::cerr << "Error: broken frame, connection closed" << std::endl;
+            break;
+        }
+
+        auto frame = std::make_shared<std::vector<char>>(len);
+        if (!readFull(conn->fd, frame->data(), len)) {
+            break;
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(conn->mtx);
+            conn->cv.wait(lock, [&]() { return conn->pendingCnt < MAX_PENDING_REQUESTS; });
+            conn->pendingCnt++;
+        }
+
+        pool.submit([&db, conn, frame]() {
+            auto response = answer(db, *frame);
+            {
+                std::lock_guard<std::mutex> thelock(conn->writeMtx);
+                writeFull(conn->fd, response.data(), response.size());
+            }
+            {
+                std::lock_guard<std::mutex> thelock(conn->mtx);
+                conn->pendingCnt--;
+            }
+            conn->cv.notify_all();
+        });
+    }
+    conn->done = true;
+}
+
+int main(int argc, const char* argv[]) {
+    std::string folder = argc > 1 ? argv[1] : "./chess";
+    std::string socketPath = argc > 2 ? argv[2] : "/tmp/tbdaemon.sock";
+    int threadCnt = argc > 3 ? std::atoi(argv[3]) : 0;
+    auto memMode = parseMemMode(argc > 4 ? argv[4] : "smart");
+
+    chessDb db;
+    db.preload(folder, memMode, chessLoadMode::onrequest);
+    if (db.getSize() == 0) {
+        std::cerr << "Error: could not load any endgames from folder " << folder << std::endl;
+        return -1;
+    }
+
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(addr.sun_path)) {
+        std::cerr << "Error: socket path is too long" << std::endl;
+        return -1;
+    }
+    memcpy(addr.sun_path, socketPath.c_str(), socketPath.size());
+
+    auto listenFd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    ::unlink(socketPath.c_str());
+    if (listenFd < 0 || ::bind(listenFd, (sockaddr*)&addr, sizeof(addr)) != 0 || ::listen(listenFd, 64) != 0) {
+        std::cerr << "Error: cannot listen on " << socketPath << std::endl;
+        return -1;
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+
+    chessThreadPool pool(threadCnt);
+    std::cout << "Endgames: " << db.getSize() << ", threads: " << pool.getThreadCnt() << ", listening on " << socketPath << std::endl;
+
+    std::list<std::pair<std::thread, std::shared_ptr<Connection>>> readers;
+    while (!stopping) {
+        // Readers of closed connections
+        for (auto it = readers.begin(); it != readers.end();) {
+            if (it->second->done) {
+                it->first.join();
+                it = readers.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        pollfd pfd = { listenFd, POLLIN, 0 };
+        if (::poll(&pfd, 1, 500) <= 0) {
+            continue;
+        }
+        auto fd = ::accept(listenFd, nullptr, nullptr);
+        if (fd < 0) {
+            continue;
+        }
+        auto conn = std::make_shared<Connection>(fd);
+        readers.emplace_back(std::thread(serve, std::ref(db), std::ref(pool), conn), conn);
+    }
+
+    ::close(listenFd);
+    ::unlink(socketPath.c_str());
+
+    // Readers stop at once, requests already read are answered
+    for (auto && reader : readers) {
+        ::shutdown(reader.second->fd, SHUT_RD);
+    }
+    for (auto && reader : readers) {
+        reader.first.join();
+    }
+    pool.wait();
+
+    std::cout << "Stopped, " << db.stats().toString() << std::endl;
+    return 0;
+}
+
+#endif
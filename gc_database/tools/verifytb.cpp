@@ -0,0 +1,132 @@
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+#include "chess.h"
+#include "chesspool.h"
+
+using namespace chess;
+
+/*
+ * Consistency check of whole tables: the score of every index must be the one computed from the scores
+ * of its children (chessDb::getScoreOnePly), children are read from the same folder
+ *
+ * Usage: verifytb [folder] [threads] [max reported per side] [endgame names...]
+ *
+ * Indexes are split into chunks of whole blocks, chunks are run in index order by a pool of threads (0: number
+ * of cores) thus blocks are read once and threads work on neighbour blocks. Files are loaded with memMode all.
+ * Positions with scores out of the mate range (unknown, winning, special score range) are skipped
+ */
+
+#define CHUNK_BLOCKS    16
+
+class SideCounter {
+public:
+    std::atomic<i64> checked { 0 }, skipped { 0 }, mismatches { 0 };
+
+    std::mutex  mtx;
+    std::vector<std::string> reports;
+};
+
+static void verifyChunk(chessDb& db, chessFile* pchessFile, Side side, i64 fromIdx, i64 toIdx, int maxReportCnt, SideCounter& counter) {
+    chessProbeBoard board;
+    auto xside = getXSide(side);
+    i64 checked = 0, skipped = 0, mismatches = 0;
+
+    for (auto idx = fromIdx; idx < toIdx; idx++) {
+        if (!pchessFile->setupBoard(board, idx, FlipMode::none, Side::white) || board.isIncheck(xside)) {
+            continue;
+        }
+        board.side = side;
+
+        auto score = pchessFile->getScore(idx, side);
+        if (abs(score) > chess_SCORE_MATE) {
+            skipped++;
+            continue;
+        }
+
+        checked++;
+        auto expectedScore = db.getScoreOnePly(board, side);
+        if (score != expectedScore) {
+            mismatches++;
+            std::lock_guard<std::mutex> thelock(counter.mtx);
+            if ((int)counter.reports.size() < maxReportCnt) {
+                std::ostringstream stream;
+                stream << board.getFen() << ", index " << idx << ", score " << score << ", from children " << expectedScore;
+                counter.reports.push_back(stream.str());
+            }
+        }
+    }
+
+    counter.checked += checked;
+    counter.skipped += skipped;
+    counter.mismatches += mismatches;
+}
+
+int main(int argc, const char* argv[]) {
+    std::string folder = argc > 1 ? argv[1] : "./chess";
+    int threadCnt = argc > 2 ? std::atoi(argv[2]) : 0;
+    int maxReportCnt = argc > 3 ? std::atoi(argv[3]) : 10;
+    std::vector<std::string> names(argv + MIN(argc, 4), argv + argc);
+
+    chessDb db;
+    db.preload(folder, chessMemMode::all, chessLoadMode::onrequest);
+    if (db.getSize() == 0) {
+        std::cerr << "Error: could not load any endgames from folder " << folder << std::endl;
+        return -1;
+    }
+
+    chessThreadPool pool(threadCnt);
+    std::cout << "Threads: " << pool.getThreadCnt() << std::endl;
+
+    i64 errCnt = 0;
+    for (auto && pchessFile : db.chessFileVec) {
+        if (!names.empty() && std::find(names.begin(), names.end(), pchessFile->getName()) == names.end()) {
+            continue;
+        }
+
+        pchessFile->checkToLoadHeaderAndTable();
+        if (pchessFile->loadStatus != chessLoadStatus::loaded) {
+            std::cout << pchessFile->getName() << ": not loaded" << std::endl;
+            errCnt++;
+            continue;
+        }
+        if (pchessFile->header->property & chess_PROP_SPECIAL_SCORE_RANGE) {
+            std::cout << pchessFile->getName() << ": skipped, special score range" << std::endl;
+            continue;
+        }
+
+        for (auto side : { Side::white, Side::black }) {
+            if (!pchessFile->header->isSide(side)) {
+                continue;
+            }
+
+            SideCounter counter;
+            auto startTime = std::chrono::steady_clock::now();
+
+            auto size = pchessFile->getSize();
+            const i64 chunkSize = CHUNK_BLOCKS * chess_SIZE_COMPRESS_BLOCK;
+            for (i64 fromIdx = 0; fromIdx < size; fromIdx += chunkSize) {
+                auto toIdx = MIN(size, fromIdx + chunkSize);
+                pool.submit([&db, pchessFile, side, fromIdx, toIdx, maxReportCnt, &counter]() {
+                    verifyChunk(db, pchessFile, side, fromIdx, toIdx, maxReportCnt, counter);
+                });
+            }
+            pool.wait();
+
+            auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+            std::cout << pchessFile->getName() << (side == Side::white ? "w" : "b") << ": " << counter.checked << " checked, "
+                      << counter.skipped << " skipped, " << counter.mismatches << " mismatches, " << elapsed << " s, "
+                      << (i64)(size / MAX(elapsed, 1e-9)) << " indexes/s" << std::endl;
+            for (auto && report : counter.reports) {
+                std::cout << "  " << report << std::endl;
+            }
+            errCnt += counter.mismatches;
+        }
+    }
+
+    std::cout << (errCnt ? "failed" : "passed") << std::endl;
+    return errCnt ? 1 : 0;
+}
@@ -0,0 +1,140 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+
+#include "chess.h"
+
+using namespace chess;
+
+/*
+ * Converter of LZMA compressed files into LZ4 ones
+ *
+ * Usage: zmtlz4 <input folder> <output folder>
+ *
+ * Each block is decompressed then compressed again by LZ4, blocks which can't be
+ * made smaller are stored uncompressed. Header and block table keep their layout,
+ * the header gets the property chess_PROP_LZ4. Other files are copied as they are
+ */
+
+static bool copyFile(const std::string& path, const std::string& outPath) {
+    std::ifstream in(path, std::ios::binary);
+    std::ofstream out(outPath, std::ios::binary);
+    return in && out && (out << in.rdbuf());
+}
+
+static bool convertFile(const std::string& path, const std::string& outPath, i64& inSize, i64& outSize) {
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file) {
+        return false;
+    }
+    inSize = file.tellg();
+    file.seekg(0, std::ios::beg);
+
+    chessFileHeader header;
+    if (!header.readFile(file) || !header.isValid()) {
+        return false;
+    }
+
+    if (!(header.property & chess_PROP_COMPRESSED) || (header.property & chess_PROP_LZ4)) {
+        outSize = inSize;
+        return copyFile(path, outPath);
+    }
+
+    auto size = chessFile::computeSize(chessFile::pathToName(path));
+    auto blockCnt = (int)((size + chess_SIZE_COMPRESS_BLOCK - 1) / chess_SIZE_COMPRESS_BLOCK);
+    if (size <= 0) {
+        return false;
+    }
+
+    std::vector<u32> blockTable(blockCnt);
+    if (!file.read((char*)blockTable.data(), blockCnt * sizeof(u32))) {
+        return false;
+    }
+
+    auto compDataSz = (i64)(blockTable[blockCnt - 1] & ~chess_UNCOMPRESS_BIT);
+    std::vector<char> compData(compDataSz);
+    if (!file.read(compData.data(), compDataSz)) {
+        return false;
+    }
+
+    std::vector<u32> newBlockTable(blockCnt);
+    std::vector<char> newData;
+    newData.reserve(compDataSz * 2);
+
+    char buf[chess_SIZE_COMPRESS_BLOCK];
+    char lz4Buf[chess_SIZE_COMPRESS_BLOCK];
+
+    u32 offset = 0;
+    for(int i = 0; i < blockCnt; i++) {
+        auto blockStart = i == 0 ? 0 : (blockTable[i - 1] & ~chess_UNCOMPRESS_BIT);
+        auto blockSz = (int)((blockTable[i] & ~chess_UNCOMPRESS_BIT) - blockStart);
+        auto curBlockSize = (int)MIN(size - (i64)i * chess_SIZE_COMPRESS_BLOCK, (i64)chess_SIZE_COMPRESS_BLOCK);
+
+        if (blockTable[i] & chess_UNCOMPRESS_BIT) {
+            if (blockSz != curBlockSize) {
+                return false;
+            }
+            memcpy(buf, compData.data() + blockStart, blockSz);
+        } else if (decompress(buf, curBlockSize, compData.data() + blockStart, blockSz) != curBlockSize) {
+            return false;
+        }
+
+        // Smaller than the block only, otherwise keep it uncompressed
+        auto lz4Sz = compressLz4(lz4Buf, curBlockSize - 1, buf, curBlockSize);
+        if (lz4Sz > 0) {
+            newData.insert(newData.end(), lz4Buf, lz4Buf + lz4Sz);
+            offset += lz4Sz;
+            newBlockTable[i] = offset;
+        } else {
+            newData.insert(newData.end(), buf, buf + curBlockSize);
+            offset += curBlockSize;
+            newBlockTable[i] = offset | chess_UNCOMPRESS_BIT;
+        }
+    }
+
+    header.property |= chess_PROP_LZ4;
+
+    std::ofstream outfile(outPath, std::ios::binary);
+    if (!outfile || !header.saveFile(outfile)) {
+        return false;
+    }
+    outfile.write((const char*)newBlockTable.data(), blockCnt * sizeof(u32));
+    outfile.write(newData.data(), newData.size());
+
+    outSize = chess_HEADER_SIZE + blockCnt * sizeof(u32) + newData.size();
+    return (bool)outfile;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        std::cerr << "Usage: zmtlz4 <input folder> <output folder>" << std::endl;
+        return 1;
+    }
+
+    std::string outFolder = argv[2];
+    i64 totalIn = 0, totalOut = 0;
+    int cnt = 0, errCnt = 0;
+
+    for (auto && path : listdir(argv[1])) {
+        if (!chessFile::knownExtension(path)) {
+            continue;
+        }
+
+        auto fileName = path.substr(path.find_last_of('/') + 1); // npos + 1 = 0
+        auto outPath = outFolder + "/" + fileName;
+        i64 inSize = 0, outSize = 0;
+        if (!convertFile(path, outPath, inSize, outSize)) {
+            std::cerr << "Error: can't convert " << path << std::endl;
+            errCnt++;
+            continue;
+        }
+
+        cnt++;
+        totalIn += inSize;
+        totalOut += outSize;
+        std::cout << fileName << ": " << inSize << " -> " << outSize << std::endl;
+    }
+
+    std::cout << "files: " << cnt << ", errors: " << errCnt << ", bytes: " << totalIn << " -> " << totalOut << std::endl;
+    return errCnt ? 1 : 0;
+}